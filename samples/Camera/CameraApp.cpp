@@ -11,7 +11,6 @@ class CameraApp : public AppAE {
 public:
 	void initializeAE() override;
 	void setupAE() override;
-	void updateAE() override;
 	void drawAE() override;
 
 private:
@@ -41,16 +40,14 @@ void CameraApp::setupAE()
 	camera_.setPerspective(60.f, static_cast<float>(getWidth()) / static_cast<float>(getHeight()), 5.f, 5000.f);
 }
 
-void CameraApp::updateAE()
+void CameraApp::drawAE()
 {
+	//read here rather than in updateAE(), so that they follow the sub-frames of motion blur
 	camera_.setParameter(getCameraParameter());
 	position_ = getParameter("Position");
 	color_ = getParameter("Color");
 	size_ = getParameter("Size");
-}
 
-void CameraApp::drawAE()
-{
 	gl::clear(ColorA(0, 0, 0, 0));
 
 	gl::ScopedViewMatrix scoped_view_matrix;
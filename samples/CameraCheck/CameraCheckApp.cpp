@@ -0,0 +1,162 @@
+#include "CinderAfterEffects.h"
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/Rand.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+using namespace atarabi;
+
+//Checks that After Effects' camera transforms survive CameraAE::setParameter and CameraAE::toTransforms:
+//the 13 values the panel sends -> the matrix AppAE builds from them -> CameraAE -> the matrix AppAE bakes -> transforms.
+//Cameras placed with CameraPersp::lookAt are baked as well, their positions must come back as the eye points.
+//Also checks that the threaded conversion matches the single-threaded one.
+class CameraCheckApp : public App {
+public:
+	void setup() override;
+
+private:
+	struct Transform {
+		vec3 position;
+		vec3 orientation;
+		float zoom;
+	};
+
+	static CameraAE::Parameter fromPanel(const Transform &transform, float height);
+	static float toFov(float zoom, float height);
+	static float angleError(float a, float b);
+};
+
+void CameraCheckApp::setup()
+{
+	static const int COUNT = 10000;
+	static const float HEIGHT = 1080.f;
+	static const float POSITION_TOLERANCE = 1e-2f;
+	static const float ANGLE_TOLERANCE = 1e-2f;
+	static const float ZOOM_TOLERANCE = 1e-2f;
+
+	Rand rand{ 0 };
+	vector<Transform> expected(COUNT);
+	vector<CameraAE::Parameter> baked(COUNT);
+	vector<CameraAE::Parameter> lookAtBaked(COUNT);
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		auto &transform = expected[i];
+		transform.position = vec3{ rand.nextFloat(-5000.f, 5000.f), rand.nextFloat(-5000.f, 5000.f), rand.nextFloat(-5000.f, 5000.f) };
+		//y stays away from +-90 degrees, where x and z are not unique
+		transform.orientation = vec3{ rand.nextFloat(-180.f, 180.f), rand.nextFloat(-80.f, 80.f), rand.nextFloat(-180.f, 180.f) };
+		transform.zoom = rand.nextFloat(100.f, 10000.f);
+
+		//what AppAE::setCameraParameter stores for a camera set from the panel's values
+		CameraAE camera;
+		camera.setParameter(fromPanel(transform, HEIGHT));
+		baked[i] = CameraAE::Parameter{ camera.getFov(), camera.getInverseViewMatrix() };
+
+		//and for a camera the app placed itself
+		CameraPersp persp;
+		persp.setPerspective(toFov(transform.zoom, HEIGHT), 16.f / 9.f, 1.f, 10000.f);
+		persp.lookAt(transform.position, transform.position + rand.nextVec3());
+		lookAtBaked[i] = CameraAE::Parameter{ persp.getFov(), persp.getInverseViewMatrix() };
+	}
+
+	CameraAE::Transforms single, multi, lookAt;
+	CameraAE::toTransforms(baked, HEIGHT, &single, 1);
+	CameraAE::toTransforms(baked, HEIGHT, &multi, static_cast<int>(thread::hardware_concurrency()));
+	CameraAE::toTransforms(lookAtBaked, HEIGHT, &lookAt, 1);
+
+	int failures = 0, lookAtFailures = 0, mismatches = 0;
+	float maxPosition = 0.f, maxAngle = 0.f, maxZoom = 0.f, maxLookAtPosition = 0.f;
+
+	for (int i = 0; i < COUNT; ++i)
+	{
+		const auto &transform = expected[i];
+
+		float position = std::max({ std::abs(single.positionX[i] - transform.position.x), std::abs(single.positionY[i] - transform.position.y), std::abs(single.positionZ[i] - transform.position.z) });
+		float angle = std::max({ angleError(single.orientationX[i], transform.orientation.x), angleError(single.orientationY[i], transform.orientation.y), angleError(single.orientationZ[i], transform.orientation.z) });
+		float zoom = std::abs(single.zoom[i] - transform.zoom) / transform.zoom;
+
+		maxPosition = std::max(maxPosition, position);
+		maxAngle = std::max(maxAngle, angle);
+		maxZoom = std::max(maxZoom, zoom);
+
+		if (position > POSITION_TOLERANCE || angle > ANGLE_TOLERANCE || zoom > ZOOM_TOLERANCE)
+		{
+			if (failures++ < 10)
+			{
+				console() << "frame " << i << ": expected " << transform.position << " " << transform.orientation << " " << transform.zoom
+					<< ", got " << vec3{ single.positionX[i], single.positionY[i], single.positionZ[i] } << " " << vec3{ single.orientationX[i], single.orientationY[i], single.orientationZ[i] } << " " << single.zoom[i] << endl;
+			}
+		}
+
+		float lookAtPosition = std::max({ std::abs(lookAt.positionX[i] - transform.position.x), std::abs(lookAt.positionY[i] - transform.position.y), std::abs(lookAt.positionZ[i] - transform.position.z) });
+		float lookAtZoom = std::abs(lookAt.zoom[i] - transform.zoom) / transform.zoom;
+		maxLookAtPosition = std::max(maxLookAtPosition, lookAtPosition);
+
+		if (lookAtPosition > POSITION_TOLERANCE || lookAtZoom > ZOOM_TOLERANCE)
+		{
+			if (lookAtFailures++ < 10)
+			{
+				console() << "lookAt " << i << ": expected " << transform.position << " " << transform.zoom
+					<< ", got " << vec3{ lookAt.positionX[i], lookAt.positionY[i], lookAt.positionZ[i] } << " " << lookAt.zoom[i] << endl;
+			}
+		}
+
+		if (single.positionX[i] != multi.positionX[i] || single.positionY[i] != multi.positionY[i] || single.positionZ[i] != multi.positionZ[i]
+			|| single.orientationX[i] != multi.orientationX[i] || single.orientationY[i] != multi.orientationY[i] || single.orientationZ[i] != multi.orientationZ[i]
+			|| single.zoom[i] != multi.zoom[i])
+		{
+			++mismatches;
+		}
+	}
+
+	console() << COUNT << " cameras: " << failures << " round trip failures, " << lookAtFailures << " lookAt failures, " << mismatches << " threaded mismatches" << endl;
+	console() << "max error: position " << maxPosition << ", orientation " << maxAngle << " degrees, zoom " << maxZoom * 100.f << "%, lookAt position " << maxLookAtPosition << endl;
+	console() << (failures == 0 && lookAtFailures == 0 && mismatches == 0 ? "PASSED" : "FAILED") << endl;
+
+	quit();
+}
+
+//the values in the order the panel sends them, put into a matrix the way AppAE does when it receives "CameraAE"
+CameraAE::Parameter CameraCheckApp::fromPanel(const Transform &transform, float height)
+{
+	vec3 radians = glm::radians(transform.orientation);
+	float cx = std::cos(radians.x), sx = std::sin(radians.x);
+	float cy = std::cos(radians.y), sy = std::sin(radians.y);
+	float cz = std::cos(radians.z), sz = std::sin(radians.z);
+
+	//the rotation X * Y * Z, row by row
+	const float r[3][3] = {
+		{ cy * cz, -cy * sz, sy },
+		{ sx * sy * cz + cx * sz, -sx * sy * sz + cx * cz, -sx * cy },
+		{ -cx * sy * cz + sx * sz, cx * sy * sz + sx * cz, cx * cy }
+	};
+	const vec3 &p = transform.position;
+
+	mat4 cameraMatrix{
+		r[0][0], r[0][1], r[0][2], 0.f,
+		r[1][0], r[1][1], r[1][2], 0.f,
+		r[2][0], r[2][1], r[2][2], 0.f,
+		p.x, p.y, p.z, 1.f
+	};
+
+	return{ toFov(transform.zoom, height), cameraMatrix };
+}
+
+//the inverse of the zoom in toTransforms
+float CameraCheckApp::toFov(float zoom, float height)
+{
+	return glm::degrees(2.f * std::atan(0.5f * height / zoom));
+}
+
+float CameraCheckApp::angleError(float a, float b)
+{
+	float difference = std::fmod(std::abs(a - b), 360.f);
+	return std::min(difference, 360.f - difference);
+}
+
+CINDER_APP(CameraCheckApp, RendererGl)
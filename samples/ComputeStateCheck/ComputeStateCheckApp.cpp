@@ -0,0 +1,148 @@
+#include "CinderAfterEffects.h"
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Rand.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+using namespace atarabi;
+
+//Checks that a ComputeState survives the trip a checkpoint takes:
+//steps on the GPU -> requestSnapshot/pollSnapshot -> saveSnapshot -> loadSnapshot -> upload into a new state -> more steps,
+//which must end where stepping without the checkpoint ends. Also checks that damaged or mismatched files are refused.
+class ComputeStateCheckApp : public App {
+public:
+	void setup() override;
+
+private:
+	void step(ComputeState &state, int steps);
+	bool check(const char *name, bool passed);
+
+	gl::GlslProgRef program_;
+	int failures_ = 0;
+};
+
+namespace {
+
+const int WORK_GROUP_SIZE = 64;
+const int COUNT = WORK_GROUP_SIZE * 1024;
+
+//adds 1 to every value, reading binding 0 and writing binding 1
+const char *STEP_SHADER =
+	"#version 430\n"
+	"layout(local_size_x = 64) in;\n"
+	"layout(std430, binding = 0) readonly buffer Read { uint src[]; };\n"
+	"layout(std430, binding = 1) writeonly buffer Write { uint dst[]; };\n"
+	"void main() { uint i = gl_GlobalInvocationID.x; dst[i] = src[i] + 1u; }\n";
+
+} //anonymous namespace
+
+void ComputeStateCheckApp::setup()
+{
+	static const int STEPS_BEFORE = 3;
+	static const int STEPS_AFTER = 4;
+	static const uint32_t FRAME = 42;
+
+	try
+	{
+		program_ = gl::GlslProg::create(gl::GlslProg::Format{}.compute(STEP_SHADER));
+	}
+	catch (const gl::GlslProgCompileExc &e)
+	{
+		console() << e.what() << endl;
+		console() << "FAILED" << endl;
+		quit();
+		return;
+	}
+
+	Rand rand{ 0 };
+	vector<uint32_t> initial(COUNT);
+	for (auto &value : initial)
+	{
+		value = rand.nextUint() >> 8;
+	}
+	GLsizeiptr bytes = COUNT * sizeof(uint32_t);
+
+	auto expected = [&](int steps) -> vector<uint8_t> {
+		vector<uint32_t> values(initial);
+		for (auto &value : values)
+		{
+			value += steps;
+		}
+		auto data = reinterpret_cast<const uint8_t*>(values.data());
+		return vector<uint8_t>(data, data + bytes);
+	};
+
+	//the checkpoint
+	ComputeState state{ bytes, initial.data() };
+	step(state, STEPS_BEFORE);
+	state.requestSnapshot(FRAME);
+	ComputeState::Snapshot snapshot;
+	check("snapshot", state.pollSnapshot(&snapshot, true) && snapshot.frame == FRAME && snapshot.data == expected(STEPS_BEFORE));
+
+	fs::path path = fs::temp_directory_path() / "ComputeStateCheck.snapshot";
+	ComputeState::Snapshot loaded;
+	check("save", ComputeState::saveSnapshot(snapshot, path));
+	check("load", ComputeState::loadSnapshot(path, &loaded, bytes) && loaded.frame == FRAME && loaded.data == snapshot.data);
+	check("load with another size", !ComputeState::loadSnapshot(path, &loaded, bytes + 4));
+
+	//resuming from the file goes on exactly where the uninterrupted run goes
+	step(state, STEPS_AFTER);
+	state.requestSnapshot(FRAME + STEPS_AFTER);
+	ComputeState::Snapshot uninterrupted;
+	state.pollSnapshot(&uninterrupted, true);
+
+	ComputeState resumed{ bytes };
+	check("upload with another size", !resumed.upload(initial.data(), bytes - 4));
+	check("upload", resumed.upload(loaded));
+	step(resumed, STEPS_AFTER);
+	resumed.requestSnapshot(FRAME + STEPS_AFTER);
+	ComputeState::Snapshot result;
+	check("resume", resumed.pollSnapshot(&result, true) && result.data == uninterrupted.data && result.data == expected(STEPS_BEFORE + STEPS_AFTER));
+
+	//a header claiming far more than the file holds
+	{
+		fstream stream{ path.string().c_str(), ios::binary | ios::in | ios::out };
+		uint64_t huge = 1ull << 40;
+		stream.seekp(8 + sizeof(uint32_t));
+		stream.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+	}
+	check("damaged size", !ComputeState::loadSnapshot(path, &loaded));
+
+	//a truncated file
+	fs::resize_file(path, 16);
+	check("truncated", !ComputeState::loadSnapshot(path, &loaded));
+
+	fs::remove(path);
+
+	console() << (failures_ == 0 ? "PASSED" : "FAILED") << endl;
+
+	quit();
+}
+
+void ComputeStateCheckApp::step(ComputeState &state, int steps)
+{
+	gl::ScopedGlslProg scoped_program{ program_ };
+	for (int i = 0; i < steps; ++i)
+	{
+		state.bind(0, 1);
+		gl::dispatchCompute(COUNT / WORK_GROUP_SIZE, 1, 1);
+		gl::memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		state.swap();
+	}
+}
+
+bool ComputeStateCheckApp::check(const char *name, bool passed)
+{
+	console() << name << ": " << (passed ? "ok" : "FAILED") << endl;
+	failures_ += passed ? 0 : 1;
+	return passed;
+}
+
+CINDER_APP(ComputeStateCheckApp, RendererGl)
@@ -0,0 +1,84 @@
+#include "CinderAfterEffects.h"
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/gl/gl.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+using namespace atarabi;
+
+//A consumer of the frames an AppAE publishes to shared memory instead of writing files.
+//Pass the same name as the panel's output channel on the command line.
+class FrameChannelApp : public App {
+public:
+	void setup() override;
+	void update() override;
+	void draw() override;
+
+private:
+	string name_ = "CinderAfterEffects";
+	shared_ptr<FrameChannel> channel_;
+	uint64_t write_count_ = 0;
+	Surface surface_;
+	TextureStreamer streamer_;
+	gl::TextureRef texture_;
+};
+
+void FrameChannelApp::setup()
+{
+	auto &args = getCommandLineArgs();
+	if (args.size() > 1)
+	{
+		name_ = args[1];
+	}
+}
+
+void FrameChannelApp::update()
+{
+	//AppAE creates the channel again for every render, so a closed one is dropped and opened again
+	if (channel_ && channel_->isClosed())
+	{
+		channel_.reset();
+	}
+
+	//the channel exists only while the app is rendering
+	if (!channel_)
+	{
+		channel_ = FrameChannel::open(name_);
+		write_count_ = 0;
+		if (!channel_)
+		{
+			return;
+		}
+	}
+
+	uint64_t write_count = channel_->getWriteCount();
+	if (write_count == write_count_)
+	{
+		return;
+	}
+	write_count_ = write_count;
+
+	int64_t frame = channel_->getLatestFrame();
+	if (frame >= 0 && channel_->read(static_cast<uint32_t>(frame), &surface_))
+	{
+		texture_ = streamer_.update(surface_);
+		getWindow()->setTitle(name_ + " : " + to_string(frame) + " (" + to_string(channel_->getDroppedCount()) + " dropped)");
+	}
+}
+
+void FrameChannelApp::draw()
+{
+	gl::clear(ColorA(0, 0, 0, 0));
+	if (texture_)
+	{
+		gl::draw(texture_, Rectf(texture_->getBounds()).getCenteredFit(getWindowBounds(), true));
+	}
+}
+
+CINDER_APP(FrameChannelApp, RendererGl, [](App::Settings* settings)
+{
+	settings->setWindowSize(1280, 720);
+	settings->setFrameRate(60.0f);
+})
@@ -18,6 +18,7 @@ private:
 	Color color_;
 	
 	ImageSequenceLoader loader_;
+	MovieLoader movie_loader_;
 	gl::TextureRef texture_;
 };
 
@@ -25,12 +26,24 @@ void ImageSequenceLoaderApp::initializeAE()
 {
 	addParameter("Color", Color{ 1.f, 0.5f, 0.5f });
 	loader_.setLoop(true);
+	loader_.setPrefetch();
+	movie_loader_.setLoop(true);
 }
 
 void ImageSequenceLoaderApp::setupAE()
 {
-	//the selected AV layer's source must be an image sequence.
-	loader_.load(getSourcePath());
+	//the selected AV layer's source must be an image sequence or a movie.
+	if (MovieLoader::isMovie(getSourcePath()))
+	{
+		loader_.reset();
+		//comp frames are mapped to movie frames through time, so the comp rate is needed as well as the movie's
+		movie_loader_.load(getSourcePath(), getSourceTime(), getFps());
+	}
+	else
+	{
+		movie_loader_.reset();
+		loader_.load(getSourcePath());
+	}
 	texture_.reset();
 }
 
@@ -41,7 +54,12 @@ void ImageSequenceLoaderApp::updateAE()
 	if (!loader_.empty())
 	{
 		uint32_t frame = getCurrentFrame();
-		texture_ = gl::Texture::create(loader_.getImage(frame));
+		texture_ = loader_.getTexture(frame);
+	}
+	else if (!movie_loader_.empty())
+	{
+		uint32_t frame = getCurrentFrame();
+		texture_ = movie_loader_.getTexture(frame);
 	}
 }
 
@@ -1,60 +1,19 @@
 #include "CinderAfterEffects.h"
 #include "cinder/app/RendererGl.h"
 #include "cinder/gl/gl.h"
-#include "cinder/Rand.h"
 #include "cinder/Vector.h"
 #include "cinder/Perlin.h"
 #include "cinder/Color.h"
 
 #include <vector>
 #include <cmath>
-#include <functional>
 #include <boost/range/irange.hpp>
-#include <boost/range/algorithm_ext/erase.hpp>
 
 using namespace ci;
 using namespace ci::app;
 using namespace std;
 using namespace atarabi;
 
-class Particle {
-public:
-	Particle(float birth, float life, vec2 position, vec2 velocity, Color color, float size) : birth_{ birth }, life_{ life }, position_{ position }, velocity_{ velocity }, color_{ color }, size_{ size } {}
-
-	bool update(float time, float frame_duration, std::function < vec2(vec2) > &get_accel)
-	{
-		if (time >= birth_ + life_)
-		{
-			return false;
-		}
-
-		vec2 accel = get_accel(position_);
-		velocity_ += accel;
-		position_ += velocity_;
-		return true;
-	}
-
-	void draw(gl::BatchRef &batch, float time) const
-	{
-		float rate = 1.f - 2.f * std::abs(time - (birth_ + 0.5f * life_)) / life_;
-		float size = size_ * std::sqrt(rate);
-
-		gl::ScopedModelMatrix scoped_model_matrix;
-		gl::ScopedColor scoped_color{ color_ };
-		gl::translate(vec3{ position_, 0.f });
-		gl::scale(vec3{ size });
-		batch->draw();
-	}
-
-private:
-	float birth_;
-	float life_;
-	vec2 position_;
-	vec2 velocity_;
-	ColorA color_;
-	float size_;
-};
-
 class ParticleApp : public AppAE {
 public:
 	void initializeAE() override;
@@ -65,9 +24,11 @@ public:
 
 private:
 	gl::BatchRef circle_;
+	unique_ptr<ParticleRenderer> renderer_;
+	SetterHandle mouse_;
 
 	Perlin			perlin_;
-	std::vector<Particle> particles_;
+	ParticleSystem particles_;
 	vec2 prev_position_;
 	vec2 position_;
 };
@@ -77,6 +38,7 @@ void ParticleApp::initializeAE()
 	//create a circle
 	gl::GlslProgRef shader = gl::context()->getStockShader(gl::ShaderDef().color());
 	circle_ = gl::Batch::create(geom::Circle().radius(1).subdivisions(60), shader);
+	renderer_.reset(new ParticleRenderer{ 60 });
 
 	//add parameters
 	addParameter("Number", 100.f);
@@ -87,13 +49,18 @@ void ParticleApp::initializeAE()
 	addParameter("Color", Color{ 1.f, 0.f, 0.f });
 	addParameter("Color Variance", 20.f);
 	addParameter("Size", 5.f);
+	//turn off to compare with drawing a batch per particle
+	addParameter("Instanced", true);
+
+	//bake the mouse path with half a pixel of tolerance
+	mouse_ = getSetterHandle("Mouse", ParameterType::Point);
+	setParameterTolerance("Mouse", 0.5f);
 }
 
 void ParticleApp::setupAE()
 {
 	perlin_.setSeed(0);
 	particles_.clear();
-	particles_.shrink_to_fit();
 	gl::enableAlphaBlending();
 	prev_position_ = position_ = 0.5f * vec2{ getSize() };
 }
@@ -106,7 +73,7 @@ void ParticleApp::mouseMoveAE(MouseEvent event)
 		prev_position_ = position_;
 	}
 
-	setParameter("Mouse", position_);
+	setParameter(mouse_, position_);
 }
 
 void ParticleApp::updateAE()
@@ -145,27 +112,22 @@ void ParticleApp::updateAE()
 	vec2 delta_position = position_ - prev_position_;
 	vec2 velocity = length(delta_position) > 0.f ? normalize(delta_position) * inherit_velocity : vec2{};
 
+	//the same numbers for the same frame, however the render is split
+	CounterRand rand = getRand();
+
 	for (int i : boost::irange(0, births))
 	{
 		float rate = static_cast<float>(i) / births;
 		float birth = time + frame_duration * rate;
 		float life = current_life + rate * delta_life;
 		vec2 position = prev_position_ + rate * delta_position;
-		Color color = current_color + rate * delta_color + Color(ColorModel::CM_RGB, Rand::randVec3() * color_variance);
+		Color color = current_color + rate * delta_color + Color(ColorModel::CM_RGB, rand.nextVec3() * color_variance);
 		float size = current_size + rate * delta_size;
-		particles_.emplace_back(birth, life, position + Rand::randVec2() * Rand::randFloat(emitter_radius), velocity, color, size);
+		particles_.emit(birth, life, position + rand.nextVec2() * rand.nextFloat(emitter_radius), velocity, color, size);
 	}
 
 	//update particles
-	Perlin &perlin = perlin_;
-	std::function < vec2(vec2) > get_accel = [&perlin, time, perlin_intensity](vec2 position) -> vec2 {
-		vec3 deriv = perlin.dfBm({ position.x, position.y, time * 0.01f }) * perlin_intensity;
-		return{ deriv.x, deriv.y };
-	};
-
-	boost::remove_erase_if(particles_, [time, frame_duration, &get_accel](Particle &particle) -> bool {
-		return !particle.update(time, frame_duration, get_accel);
-	});
+	particles_.update(time, ParticleSystem::perlinField(perlin_, time * 0.01f, perlin_intensity));
 
 	prev_position_ = position_;
 }
@@ -177,9 +139,38 @@ void ParticleApp::drawAE()
 
 	float time = getCurrentTime();
 
-	for (const auto &particle : particles_)
+	const auto &births = particles_.getBirths();
+	const auto &lives = particles_.getLives();
+	const auto &xs = particles_.getPositionsX();
+	const auto &ys = particles_.getPositionsY();
+	const auto &colors = particles_.getColors();
+	const auto &sizes = particles_.getSizes();
+
+	if (getParameter("Instanced"))
 	{
-		particle.draw(circle_, time);
+		//a single draw call for all particles
+		auto instances = renderer_->map(particles_.size());
+		for (size_t i = 0; instances && i < particles_.size(); ++i)
+		{
+			float rate = 1.f - 2.f * std::abs(time - (births[i] + 0.5f * lives[i])) / lives[i];
+			instances[i].position = vec2{ xs[i], ys[i] };
+			instances[i].size = sizes[i] * std::sqrt(rate);
+			instances[i].color = colors[i];
+		}
+		renderer_->draw();
+		return;
+	}
+
+	for (size_t i = 0; i < particles_.size(); ++i)
+	{
+		float rate = 1.f - 2.f * std::abs(time - (births[i] + 0.5f * lives[i])) / lives[i];
+		float size = sizes[i] * std::sqrt(rate);
+
+		gl::ScopedModelMatrix scoped_model_matrix;
+		gl::ScopedColor scoped_color{ colors[i] };
+		gl::translate(vec3{ xs[i], ys[i], 0.f });
+		gl::scale(vec3{ size });
+		circle_->draw();
 	}
 }
 
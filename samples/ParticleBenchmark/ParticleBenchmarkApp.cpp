@@ -0,0 +1,102 @@
+#include "CinderAfterEffects.h"
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/Rand.h"
+#include "cinder/Perlin.h"
+
+#include <chrono>
+#include <cmath>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+using namespace atarabi;
+
+//Prints how many particles ParticleSystem updates per millisecond, on one thread and on all cores,
+//and how long SpatialGrid takes to build and to find the neighbors of every particle.
+class ParticleBenchmarkApp : public App {
+public:
+	void setup() override;
+
+private:
+	double measure(size_t count, int num_threads);
+	void measureGrid(size_t count, float radius);
+};
+
+void ParticleBenchmarkApp::setup()
+{
+	for (size_t count : { 10000, 100000, 1000000 })
+	{
+		double single = measure(count, 1);
+		double multi = measure(count, 0);
+		console() << count << " particles: " << single << " particles/ms on 1 thread, " << multi << " particles/ms on " << thread::hardware_concurrency() << " threads" << endl;
+	}
+
+	measureGrid(100000, 5.f);
+
+	quit();
+}
+
+double ParticleBenchmarkApp::measure(size_t count, int num_threads)
+{
+	static const int FRAMES = 30;
+
+	Rand rand{ 0 };
+	Perlin perlin;
+	ParticleSystem particles{ num_threads };
+	particles.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		//nobody dies during the measurement
+		particles.emit(0.f, 1000.f, rand.nextVec2() * 1000.f, rand.nextVec2(), Color{ 1.f, 1.f, 1.f }, 1.f);
+	}
+
+	auto start = chrono::steady_clock::now();
+	for (int frame = 0; frame < FRAMES; ++frame)
+	{
+		float time = frame / 30.f;
+		particles.update(time, ParticleSystem::perlinField(perlin, time * 0.01f, 1.f));
+	}
+	double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+	return count * FRAMES / milliseconds;
+}
+
+void ParticleBenchmarkApp::measureGrid(size_t count, float radius)
+{
+	static const int FRAMES = 30;
+
+	//about 10 neighbors per particle
+	float extent = std::sqrt(count * 3.14159265f * radius * radius / 10.f);
+
+	Rand rand{ 0 };
+	vector<float> xs(count), ys(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		xs[i] = rand.nextFloat(extent);
+		ys[i] = rand.nextFloat(extent);
+	}
+
+	SpatialGrid grid{ radius };
+	size_t neighbors = 0;
+	double build = 0.0, query = 0.0;
+
+	for (int frame = 0; frame < FRAMES; ++frame)
+	{
+		auto start = chrono::steady_clock::now();
+		grid.build(xs.data(), ys.data(), count);
+		auto built = chrono::steady_clock::now();
+		for (size_t i = 0; i < count; ++i)
+		{
+			grid.query(xs[i], ys[i], radius, [&neighbors](uint32_t index, float distance_squared) { ++neighbors; });
+		}
+		auto queried = chrono::steady_clock::now();
+
+		build += chrono::duration<double, milli>(built - start).count();
+		query += chrono::duration<double, milli>(queried - built).count();
+	}
+
+	console() << count << " particles: grid build " << build / FRAMES << " ms, query " << query / FRAMES << " ms, " << static_cast<double>(neighbors) / (count * FRAMES) << " neighbors per particle" << endl;
+}
+
+CINDER_APP(ParticleBenchmarkApp, RendererGl)
@@ -1,7 +1,6 @@
 #include "CinderAfterEffects.h"
 #include "cinder/app/RendererGl.h"
 #include "cinder/gl/gl.h"
-#include "cinder/gl/Ssbo.h"
 #include "cinder/Rand.h"
 #include "cinder/CinderMath.h"
 
@@ -40,7 +39,9 @@ private:
 	gl::GlslProgRef render_program_;
 	gl::GlslProgRef update_program_;
 
-	gl::SsboRef particle_buffer_;
+	std::unique_ptr<ComputeState> state_;
+	ComputeState::Snapshot initial_state_;
+	std::vector<float> initial_key_;
 	gl::VboRef id_buffer_;
 	gl::VaoRef vao_;
 };
@@ -90,9 +91,7 @@ void ParticleCSApp::initializeAE()
 		quit();
 	}
 
-	particle_buffer_ = gl::Ssbo::create(PARTICLE_NUM * sizeof(Particle));
-	gl::ScopedBuffer scopedParticleSsbo(particle_buffer_);
-	particle_buffer_->bindBase(0);
+	state_.reset(new ComputeState{ PARTICLE_NUM * sizeof(Particle) });
 
 	std::vector<GLuint> ids(PARTICLE_NUM);
 	GLuint id = 0;
@@ -126,9 +125,19 @@ void ParticleCSApp::setupAE()
 	console() << "Damping: " << damping << std::endl;
 	console() << "Opacity: " << opacity << std::endl;
 
+	// the particles are generated again only when the parameters at frame 0 change
+	std::vector<float> key{ center.x, center.y, center.z, size, color.r, color.g, color.b, damping, opacity };
+	if (key == initial_key_)
+	{
+		state_->upload(initial_state_);
+		return;
+	}
+	initial_key_ = key;
+
 	// setup particles
-	std::vector<Particle> particles;
-	particles.assign(PARTICLE_NUM, Particle());
+	initial_state_.frame = 0;
+	initial_state_.data.assign(PARTICLE_NUM * sizeof(Particle), 0);
+	Particle *particles = reinterpret_cast<Particle*>(initial_state_.data.data());
 
 	Rand rand{ 0 };
 	for (int i = 0; i < PARTICLE_GRID; ++i)
@@ -151,13 +160,12 @@ void ParticleCSApp::setupAE()
 		}
 	}
 
-	particle_buffer_->bufferSubData(0, PARTICLE_NUM * sizeof(Particle), particles.data());
+	state_->upload(initial_state_);
 }
 
 void ParticleCSApp::updateAE()
 {
 	// update parameters
-	camera_.setParameter(getCameraParameter());
 	vec3 position1 = getParameter("Force Position 1");
 	float force1 = getParameter("Force 1");
 	vec3 position2 = getParameter("Force Position 2");
@@ -171,17 +179,22 @@ void ParticleCSApp::updateAE()
 	update_program_->uniform("uPosition2", position2);
 	update_program_->uniform("uForce2", force2);
 	update_program_->uniform("uFps", getFps());
-	gl::ScopedBuffer scopedParticleSsbo(particle_buffer_);
 
+	// read the current state and write the next one
+	state_->bind(0, 1);
 	gl::dispatchCompute(PARTICLE_NUM / WORK_GROUP_SIZE, 1, 1);
 	gl::memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	state_->swap();
 }
 
 void ParticleCSApp::drawAE()
 {
+	// the camera follows the sub-frames of motion blur, the particles are stepped once per frame
+	camera_.setParameter(getCameraParameter());
+
 	gl::clear(ColorA{ 0.f, 0.f, 0.f, 0.f });
 	gl::ScopedGlslProg program(render_program_);
-	gl::ScopedBuffer buffer(particle_buffer_);
+	state_->getCurrent()->bindBase(0);
 	gl::ScopedVao vao(vao_);
 
 	gl::setMatrices(camera_);
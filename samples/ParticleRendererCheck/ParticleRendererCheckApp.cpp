@@ -0,0 +1,127 @@
+#include "CinderAfterEffects.h"
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Rand.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+using namespace atarabi;
+
+//Checks that ParticleRenderer draws what the Particle sample draws with a batch per particle:
+//both paths render the same circles into an fbo, and the read back pixels are compared.
+//Several frames are drawn so that both instance buffers and their fences are used.
+class ParticleRendererCheckApp : public App {
+public:
+	void setup() override;
+
+private:
+	Surface8u render(const vector<ParticleRenderer::Instance> &particles, bool instanced);
+
+	gl::FboRef fbo_;
+	gl::BatchRef circle_;
+	unique_ptr<ParticleRenderer> renderer_;
+};
+
+void ParticleRendererCheckApp::setup()
+{
+	static const int WIDTH = 1280;
+	static const int HEIGHT = 720;
+	static const int FRAMES = 5;
+	static const int COUNT = 2000;
+	//a channel may differ by rounding, and the edges of a circle by rasterization
+	static const int CHANNEL_TOLERANCE = 2;
+	static const double PIXEL_TOLERANCE = 1e-3;
+
+	//no msaa, so that both paths are resolved the same way
+	fbo_ = gl::Fbo::create(WIDTH, HEIGHT, gl::Fbo::Format().disableDepth());
+	circle_ = gl::Batch::create(geom::Circle().radius(1).subdivisions(ParticleRenderer::DEFAULT_SUBDIVISIONS), gl::context()->getStockShader(gl::ShaderDef().color()));
+	renderer_.reset(new ParticleRenderer{ ParticleRenderer::DEFAULT_SUBDIVISIONS });
+
+	console() << "instance buffers: " << (renderer_->isPersistent() ? "persistent" : "mapped every frame") << endl;
+
+	Rand rand{ 0 };
+	int failures = 0;
+
+	for (int frame = 0; frame < FRAMES; ++frame)
+	{
+		//a different count each frame, so that the buffers are reused partly
+		vector<ParticleRenderer::Instance> particles(COUNT - frame * 100);
+		for (auto &particle : particles)
+		{
+			particle.position = vec2{ rand.nextFloat(0.f, WIDTH), rand.nextFloat(0.f, HEIGHT) };
+			particle.size = rand.nextFloat(1.f, 30.f);
+			particle.color = ColorA{ rand.nextFloat(), rand.nextFloat(), rand.nextFloat(), rand.nextFloat(0.3f, 1.f) };
+		}
+
+		Surface8u batched = render(particles, false);
+		Surface8u instanced = render(particles, true);
+
+		int differing = 0, maxDifference = 0;
+		for (int32_t y = 0; y < HEIGHT; ++y)
+		{
+			const uint8_t *a = batched.getData() + batched.getRowBytes() * y;
+			const uint8_t *b = instanced.getData() + instanced.getRowBytes() * y;
+			for (int32_t x = 0; x < WIDTH * batched.getPixelInc(); x += batched.getPixelInc())
+			{
+				int difference = 0;
+				for (int c = 0; c < batched.getPixelInc(); ++c)
+				{
+					difference = std::max(difference, std::abs(a[x + c] - b[x + c]));
+				}
+				maxDifference = std::max(maxDifference, difference);
+				differing += difference > CHANNEL_TOLERANCE ? 1 : 0;
+			}
+		}
+
+		double rate = static_cast<double>(differing) / (WIDTH * HEIGHT);
+		bool passed = rate <= PIXEL_TOLERANCE;
+		failures += passed ? 0 : 1;
+		console() << "frame " << frame << ": " << particles.size() << " particles, " << differing << " differing pixels(" << rate * 100.0 << "%), max channel difference " << maxDifference << (passed ? "" : " FAILED") << endl;
+	}
+
+	console() << (failures == 0 ? "PASSED" : "FAILED") << endl;
+
+	quit();
+}
+
+//the two paths of ParticleApp::drawAE with the same sizes and colors
+Surface8u ParticleRendererCheckApp::render(const vector<ParticleRenderer::Instance> &particles, bool instanced)
+{
+	gl::ScopedFramebuffer scoped_framebuffer{ fbo_ };
+	gl::ScopedViewport scoped_viewport{ ivec2{ 0 }, fbo_->getSize() };
+	gl::ScopedMatrices scoped_matrices;
+	gl::setMatricesWindow(fbo_->getSize());
+	gl::enableAlphaBlending();
+	gl::clear(ColorA(0, 0, 0, 0));
+
+	if (instanced)
+	{
+		auto instances = renderer_->map(particles.size());
+		if (instances)
+		{
+			std::copy(particles.begin(), particles.end(), instances);
+		}
+		renderer_->draw();
+	}
+	else
+	{
+		for (const auto &particle : particles)
+		{
+			gl::ScopedModelMatrix scoped_model_matrix;
+			gl::ScopedColor scoped_color{ particle.color };
+			gl::translate(vec3{ particle.position, 0.f });
+			gl::scale(vec3{ particle.size });
+			circle_->draw();
+		}
+	}
+
+	return fbo_->readPixels8u(fbo_->getBounds());
+}
+
+CINDER_APP(ParticleRendererCheckApp, RendererGl)
@@ -0,0 +1,111 @@
+#include "CinderAfterEffects.h"
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/Timeline.h"
+#include "cinder/Tween.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+using namespace atarabi;
+
+//Checks that TimelineAE steps tweens as cinder::Timeline does while they are applied, re-applied and appended during a render:
+//the same script runs on both timelines and the animated values are compared at every frame.
+//Re-applying a tween replaces the previous one of its target, so the number of items stays the same.
+class TimelineCheckApp : public App {
+public:
+	void setup() override;
+
+private:
+	struct Values {
+		Anim<float> a{ 0.f };
+		Anim<float> b{ 0.f };
+		Anim<float> c{ 0.f };
+	};
+
+	//what the app does at frame, on either timeline(apps call TimelineAE's own adders through timelineAE())
+	template<class TimelineType>
+	static void script(TimelineType &timeline, Values &values, int frame);
+};
+
+void TimelineCheckApp::setup()
+{
+	static const int FRAMES = 150;
+	static const float FPS = 30.f;
+	static const float TOLERANCE = 1e-4f;
+
+	TimelineRef reference = Timeline::create();
+	TimelineAERef timeline = TimelineAE::create();
+	Values expected, actual;
+
+	int failures = 0;
+	float maxError = 0.f;
+
+	for (int frame = 0; frame < FRAMES; ++frame)
+	{
+		float time = frame / FPS;
+		reference->stepTo(time);
+		timeline->stepTo(time);
+
+		script(*reference, expected, frame);
+		script(*timeline, actual, frame);
+
+		float error = std::max({ std::abs(expected.a - actual.a), std::abs(expected.b - actual.b), std::abs(expected.c - actual.c) });
+		maxError = std::max(maxError, error);
+		if (error > TOLERANCE && failures++ < 10)
+		{
+			console() << "frame " << frame << ": expected " << expected.a.value() << " " << expected.b.value() << " " << expected.c.value()
+				<< ", got " << actual.a.value() << " " << actual.b.value() << " " << actual.c.value() << endl;
+		}
+	}
+
+	console() << FRAMES << " frames: " << failures << " mismatches, max error " << maxError << endl;
+	console() << (failures == 0 ? "PASSED" : "FAILED") << endl;
+
+	quit();
+}
+
+template<class TimelineType>
+void TimelineCheckApp::script(TimelineType &timeline, Values &values, int frame)
+{
+	switch (frame)
+	{
+		case 0:
+			timeline.apply(&values.a, 100.f, 2.f);
+			timeline.apply(&values.b, 10.f, 1.f).delay(0.5f);
+			break;
+		case 15:
+			//while a is running
+			timeline.apply(&values.a, -50.f, 1.f);
+			break;
+		case 20:
+			//before the delayed b has started
+			timeline.apply(&values.b, 20.f, 1.f).delay(0.5f);
+			break;
+		case 40:
+			//twice in the same frame
+			timeline.apply(&values.a, 30.f, 1.f);
+			timeline.apply(&values.a, 60.f, 0.5f);
+			break;
+		case 60:
+			//after b has completed and been removed
+			timeline.apply(&values.b, -20.f, 0.5f);
+			timeline.apply(&values.c, 5.f, 1.f);
+			break;
+		case 70:
+			timeline.appendTo(&values.c, 15.f, 1.f);
+			break;
+		case 80:
+			//while c is running, with its appended tween still to come
+			timeline.apply(&values.c, -5.f, 2.f);
+			break;
+		default:
+			break;
+	}
+}
+
+CINDER_APP(TimelineCheckApp, RendererGl)
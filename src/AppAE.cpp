@@ -28,10 +28,12 @@
 #include <iomanip>
 #include <algorithm>
 #include <sstream>
+#include <fstream>
 #include <cassert>
 #include <stdexcept>
 #include <chrono>
 #include <thread>
+#include <limits>
 
 namespace atarabi {
 
@@ -59,6 +61,16 @@ std::string parmeterTypeToString(ParameterType type)
 			return "point3d";
 		case ParameterType::Color:
 			return "color";
+		case ParameterType::Angle:
+			return "angle";
+		case ParameterType::Integer:
+			return "integer";
+		case ParameterType::Popup:
+			return "popup";
+		case ParameterType::ColorA:
+			return "colora";
+		case ParameterType::FloatArray:
+			return "floatarray";
 	}
 
 	assert(0);
@@ -89,16 +101,301 @@ void addValueToMessage(cinder::osc::Message &message, ParameterType type, Parame
 			message.append(value.color.g);
 			message.append(value.color.b);
 			break;
+		case ParameterType::Angle:
+			message.append(value.angle.value);
+			break;
+		case ParameterType::Integer:
+			message.append(value.integer.value);
+			break;
+		case ParameterType::Popup:
+			message.append(value.popup.value);
+			break;
+		case ParameterType::ColorA:
+			message.append(value.colorA.r);
+			message.append(value.colorA.g);
+			message.append(value.colorA.b);
+			message.append(value.colorA.a);
+			break;
+		case ParameterType::FloatArray:
+			//arrays do not fit in a value, see addArrayToMessage
+			assert(0);
+			break;
+	}
+}
+
+//the number of floats followed by the floats
+void addArrayToMessage(cinder::osc::Message &message, const std::vector<float> &values)
+{
+	message.append(static_cast<int32_t>(values.size()));
+	for (float value : values)
+	{
+		message.append(value);
+	}
+}
+
+std::string joinOptions(const std::vector<std::string> &options)
+{
+	std::string joined;
+	for (std::size_t i = 0; i < options.size(); ++i)
+	{
+		if (i > 0)
+		{
+			joined += "|";
+		}
+		joined += options[i];
+	}
+	return joined;
+}
+
+int getComponents(ParameterType type, const ParameterValue &value, float *components)
+{
+	switch (type)
+	{
+		case ParameterType::Checkbox:
+			components[0] = value.checkbox.value ? 1.f : 0.f;
+			return 1;
+		case ParameterType::Slider:
+			components[0] = value.slider.value;
+			return 1;
+		case ParameterType::Point:
+			components[0] = value.point.x;
+			components[1] = value.point.y;
+			return 2;
+		case ParameterType::Point3D:
+			components[0] = value.point3d.x;
+			components[1] = value.point3d.y;
+			components[2] = value.point3d.z;
+			return 3;
+		case ParameterType::Color:
+			components[0] = value.color.r;
+			components[1] = value.color.g;
+			components[2] = value.color.b;
+			return 3;
+		case ParameterType::Angle:
+			components[0] = value.angle.value;
+			return 1;
+		case ParameterType::Integer:
+			components[0] = static_cast<float>(value.integer.value);
+			return 1;
+		case ParameterType::Popup:
+			components[0] = static_cast<float>(value.popup.value);
+			return 1;
+		case ParameterType::ColorA:
+			components[0] = value.colorA.r;
+			components[1] = value.colorA.g;
+			components[2] = value.colorA.b;
+			components[3] = value.colorA.a;
+			return 4;
+		case ParameterType::FloatArray:
+			break;
+	}
+
+	return 0;
+}
+
+//collapses the values of the same frame(the last one wins) and drops the frames which are within tolerance of the line between the kept ones(Ramer-Douglas-Peucker)
+//the line stands for AE's interpolation between the kept keyframes, so this is only exact with linear temporal and spatial interpolation
+void simplifyValues(ParameterType type, float tolerance, std::vector<std::pair<int32_t, ParameterValue>> &values)
+{
+	std::stable_sort(values.begin(), values.end(), [](const std::pair<int32_t, ParameterValue> &lhs, const std::pair<int32_t, ParameterValue> &rhs) -> bool {
+		return lhs.first < rhs.first;
+	});
+
+	std::size_t size = 0;
+	for (std::size_t i = 0; i < values.size(); ++i)
+	{
+		if (size > 0 && values[size - 1].first == values[i].first)
+		{
+			values[size - 1] = values[i];
+		}
+		else
+		{
+			values[size++] = values[i];
+		}
+	}
+	values.resize(size);
+
+	if (size <= 2)
+	{
+		return;
+	}
+
+	//checkboxes and popups hold their value, only the changes are keyframes
+	if (type == ParameterType::Checkbox || type == ParameterType::Popup)
+	{
+		auto last = std::unique(values.begin(), values.end(), [type](const std::pair<int32_t, ParameterValue> &lhs, const std::pair<int32_t, ParameterValue> &rhs) -> bool {
+			return type == ParameterType::Checkbox ? lhs.second.checkbox.value == rhs.second.checkbox.value : lhs.second.popup.value == rhs.second.popup.value;
+		});
+		values.erase(last, values.end());
+		return;
+	}
+
+	static const int MAX_COMPONENT_NUM = 4;
+
+	std::vector<float> components(size * MAX_COMPONENT_NUM);
+	int numComponents = 0;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		numComponents = getComponents(type, values[i].second, &components[i * MAX_COMPONENT_NUM]);
+	}
+
+	std::vector<bool> keep(size, false);
+	keep.front() = keep.back() = true;
+
+	std::vector<std::pair<std::size_t, std::size_t>> ranges;
+	ranges.push_back(std::make_pair(0, size - 1));
+
+	while (!ranges.empty())
+	{
+		std::size_t first = ranges.back().first;
+		std::size_t last = ranges.back().second;
+		ranges.pop_back();
+
+		float firstFrame = static_cast<float>(values[first].first);
+		float span = static_cast<float>(values[last].first) - firstFrame;
+
+		std::size_t farthest = first;
+		float maxDistance = tolerance;
+		for (std::size_t i = first + 1; i < last; ++i)
+		{
+			float t = (static_cast<float>(values[i].first) - firstFrame) / span;
+			float distance = 0.f;
+			for (int c = 0; c < numComponents; ++c)
+			{
+				float a = components[first * MAX_COMPONENT_NUM + c];
+				float b = components[last * MAX_COMPONENT_NUM + c];
+				distance = std::max(distance, std::abs(components[i * MAX_COMPONENT_NUM + c] - (a + t * (b - a))));
+			}
+
+			if (distance > maxDistance)
+			{
+				maxDistance = distance;
+				farthest = i;
+			}
+		}
+
+		if (farthest != first)
+		{
+			keep[farthest] = true;
+			if (farthest - first > 1)
+			{
+				ranges.push_back(std::make_pair(first, farthest));
+			}
+			if (last - farthest > 1)
+			{
+				ranges.push_back(std::make_pair(farthest, last));
+			}
+		}
+	}
+
+	std::size_t kept = 0;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		if (keep[i])
+		{
+			values[kept++] = values[i];
+		}
+	}
+	values.resize(kept);
+}
+
+void replaceAll(std::string &text, const std::string &from, const std::string &to)
+{
+	for (std::size_t pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size()))
+	{
+		text.replace(pos, from.size(), to);
+	}
+}
+
+//raw frames on the standard input, {width}, {height}, {fps} and {output} are replaced when rendering starts
+const char *DEFAULT_ENCODER_COMMAND = "ffmpeg -y -loglevel error -f rawvideo -pix_fmt rgba -s {width}x{height} -r {fps} -i - -pix_fmt yuv420p {output}";
+const char *DEFAULT_ENCODER_PRESET = "h264";
+
+//more presets are read from this file next to the executable, one "name=command" per line
+const char *ENCODER_PRESETS_FILE = "encoders.txt";
+
+//the command is run by a shell, so the path is passed as one quoted argument whatever it contains
+bool quoteArgument(const std::string &arg, std::string &quoted)
+{
+#if defined(CINDER_MSW)
+	//cmd.exe expands %VAR% even inside quotes and has no escape for a quote, such paths are refused
+	if (arg.find_first_of("\"%\r\n") != std::string::npos)
+	{
+		return false;
+	}
+	quoted = "\"" + arg + "\"";
+#else
+	quoted = "'";
+	for (char c : arg)
+	{
+		if (c == '\'')
+		{
+			quoted += "'\\''";
+		}
+		else
+		{
+			quoted += c;
+		}
+	}
+	quoted += "'";
+#endif
+	return true;
+}
+
+//how long to wait for After Effects to share the pixels of a layer frame
+const double LAYER_TIMEOUT = 1.0;
+
+//points are in layer pixels, so they follow the proxy resolution
+ParameterValue scaleParameter(ParameterType type, ParameterValue value, float scale)
+{
+	switch (type)
+	{
+		case ParameterType::Point:
+			value.point.x *= scale;
+			value.point.y *= scale;
+			break;
+		case ParameterType::Point3D:
+			value.point3d.x *= scale;
+			value.point3d.y *= scale;
+			value.point3d.z *= scale;
+			break;
+		default:
+			break;
 	}
+	return value;
+}
+
+//scaling the camera position as well as the points keeps the projection of the scene unchanged
+CameraAE::Parameter scaleCamera(CameraAE::Parameter parameter, float scale)
+{
+	parameter.cameraMatrix[3].x *= scale;
+	parameter.cameraMatrix[3].y *= scale;
+	parameter.cameraMatrix[3].z *= scale;
+	return parameter;
+}
+
+template<class T>
+ParameterValue interpolate(const ParameterValue &from, const ParameterValue &to, float t)
+{
+	T fromValue = from;
+	T toValue = to;
+	return cinder::lerp(fromValue, toValue, t);
 }
 
 } //anonymous namespace
 
-AppAE::AppAE(): mSender( LOCAL_PORT, "127.0.0.1", EXTENSION_PORT ), mReceiver( APP_PORT ) {}
+const int AppAE::MAX_CAMERA_ARG_NUM;
+const int AppAE::MAX_ARG_NUM;
+const int AppAE::MAX_STREAM_MESSAGES_PER_FRAME;
+const int AppAE::MAX_STREAM_BACKLOG;
+const uint32_t AppAE::OUTPUT_CHANNEL_SLOTS;
+
+AppAE::AppAE(): mSender( LOCAL_PORT, "127.0.0.1", EXTENSION_PORT ), mReceiver( asio::ip::udp::endpoint{ asio::ip::address_v4::loopback(), APP_PORT } ), mWriter( ImageWriter::DEFAULT_BUFFER_SIZE, 0 ) {}
 
 void AppAE::setup()
 {
 	mPath = cinder::getHomeDirectory().string();
+	loadEncoderPresets();
 	mSender.bind();
 	mReceiver.setListener("/cinder/*", [this] (const cinder::osc::Message &message) {
 		std::cout << message.getAddress() << std::endl;
@@ -114,11 +411,14 @@ void AppAE::update()
 {
 	if (mState == State::Render)
 	{
+		//updateAE() sees the frame itself, also with motion blur
+		mSubFrame = 0.f;
 		timelineAE().stepTo(getCurrentTime());
+		mHasDirtyRect = false;
 
 		if (useFbo())
 		{
-			cinder::gl::ScopedFramebuffer scopedFrameBuffer{ mFbo };
+			cinder::gl::ScopedFramebuffer scopedFrameBuffer{ mRenderTarget->getRenderFbo() };
 			updateAE();
 		}
 		else
@@ -133,12 +433,25 @@ void AppAE::draw()
 {
 	if (mState == State::Render)
 	{
+		auto drawStart = std::chrono::steady_clock::now();
+		mFrameRegion = useFbo() ? calcFrameRegion() : cinder::Area{ 0, 0, getWidth(), getHeight() };
+
 		//draw
+		if (isMotionBlurred())
+		{
+			drawMotionBlur();
+		}
+		else
 		{
 			if (useFbo())
 			{
-				cinder::gl::ScopedFramebuffer scopedFrameBuffer{ mFbo };
-				drawAE();
+				{
+					cinder::gl::ScopedFramebuffer scopedFrameBuffer{ mRenderTarget->getRenderFbo() };
+					auto scissor = mRenderTarget->getRenderScissor(mFrameRegion);
+					cinder::gl::ScopedScissor scopedScissor{ scissor.first, scissor.second };
+					drawAE();
+				}
+				mRenderTarget->resolve(mFrameRegion);
 			}
 			else
 			{
@@ -147,10 +460,15 @@ void AppAE::draw()
 			}
 		}
 
+		auto drawEnd = std::chrono::steady_clock::now();
+		mDrawSeconds += std::chrono::duration<double>(drawEnd - drawStart).count();
+
 		//write
 		if (mWrite)
 		{
 			writeImage();
+			//the readback waits for the GPU to finish drawing
+			mReadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - drawEnd).count();
 		}
 
 		//reply
@@ -160,6 +478,12 @@ void AppAE::draw()
 			mSender.send(reply);
 		}
 
+		//stream
+		if (mWrite && mStream)
+		{
+			streamSetters(false);
+		}
+
 		++mCurrentFrame;
 
 		if (mCurrentFrame >= mDuration)
@@ -226,50 +550,381 @@ void AppAE::addParameter(const std::string &name, ParameterType type, ParameterV
 	}
 }
 
+void AppAE::addParameter(const std::string &name, const std::vector<std::string> &options, int32_t initialValue)
+{
+	assert(mState == State::Uninitialized && name != "CameraAE" && !options.empty());
+
+	if (mGetters.count(name) == 0)
+	{
+		auto &getter = mGetters.insert(std::make_pair(name, Getter{ static_cast<uint32_t>(mGetters.size()), name, ParameterType::Popup, initialValue })).first->second;
+		getter.options = options;
+	}
+}
+
+void AppAE::addParameter(const std::string &name, const std::vector<float> &initialValue)
+{
+	assert(mState == State::Uninitialized && name != "CameraAE");
+
+	if (mGetters.count(name) == 0)
+	{
+		auto &getter = mGetters.insert(std::make_pair(name, Getter{ static_cast<uint32_t>(mGetters.size()), name, ParameterType::FloatArray, ParameterValue{} })).first->second;
+		getter.initialArray = initialValue;
+	}
+}
+
 ParameterValue AppAE::getParameter(const std::string &name, uint32_t frame) const
 {
 	assert(mState == State::Render && mGetters.count(name) > 0);
 
 	if (frame >= mDuration)
 	{
-		frame = mDuration - 1;
+		frame = mDuration - 1;
+	}
+
+	const auto it = mGetters.find(name);
+	const auto &getter = it->second;
+
+	return scaleParameter(getter.type, getter.values[frame], mProxyScale);
+}
+
+ParameterValue AppAE::getParameterAt(const std::string &name, float frame) const
+{
+	assert(mState == State::Render && mGetters.count(name) > 0);
+
+	uint32_t first, second;
+	float t;
+	splitFrame(frame, &first, &second, &t);
+
+	const auto it = mGetters.find(name);
+	const auto &getter = it->second;
+	const ParameterValue from = scaleParameter(getter.type, getter.values[first], mProxyScale);
+	const ParameterValue to = scaleParameter(getter.type, getter.values[second], mProxyScale);
+
+	switch (getter.type)
+	{
+		case ParameterType::Slider:
+		case ParameterType::Angle:
+			return interpolate<float>(from, to, t);
+		case ParameterType::Point:
+			return interpolate<cinder::vec2>(from, to, t);
+		case ParameterType::Point3D:
+			return interpolate<cinder::vec3>(from, to, t);
+		case ParameterType::Color:
+			return interpolate<cinder::Color>(from, to, t);
+		case ParameterType::ColorA:
+			return interpolate<cinder::ColorA>(from, to, t);
+		default:
+			//discrete values hold until the next frame
+			return from;
+	}
+}
+
+std::vector<float> AppAE::getArrayParameter(const std::string &name, uint32_t frame) const
+{
+	assert(mState == State::Render && mGetters.count(name) > 0);
+
+	if (frame >= mDuration)
+	{
+		frame = mDuration - 1;
+	}
+
+	const auto it = mGetters.find(name);
+	const auto &getter = it->second;
+	assert(getter.type == ParameterType::FloatArray);
+
+	//each value is the offset of the frame's floats
+	std::size_t first = getter.values[frame].integer.value;
+	std::size_t last = frame + 1 < getter.values.size() ? getter.values[frame + 1].integer.value : getter.arrayValues.size();
+
+	return std::vector<float>(getter.arrayValues.begin() + first, getter.arrayValues.begin() + last);
+}
+
+CameraAE::Parameter AppAE::getCameraParameter(uint32_t frame) const
+{
+	assert(mState == State::Render && mUseCamera);
+
+	if (frame >= mDuration)
+	{
+		frame = mDuration - 1;
+	}
+
+	return scaleCamera(mCameraGetters[frame], mProxyScale);
+}
+
+void AppAE::setDirtyRect(const cinder::Area &area)
+{
+	assert(mState == State::Render);
+
+	//the rects of several calls in a frame add up
+	if (mHasDirtyRect)
+	{
+		mDirtyRect.include(area);
+	}
+	else
+	{
+		mDirtyRect = area;
+		mHasDirtyRect = true;
+	}
+}
+
+cinder::Area AppAE::calcFrameRegion() const
+{
+	cinder::Area region{ 0, 0, getWidth(), getHeight() };
+
+	//the dirty rects are changes from the previous frame, so the first one is drawn whole
+	if (mHasDirtyRect && mCurrentFrame > 0)
+	{
+		region.clipBy(mDirtyRect);
+	}
+
+	//in layer pixels
+	if (mRegionOfInterest.getWidth() > 0 && mRegionOfInterest.getHeight() > 0)
+	{
+		region.clipBy(cinder::Area{
+			static_cast<int32_t>(std::floor(mRegionOfInterest.x1 * mProxyScale)),
+			static_cast<int32_t>(std::floor(mRegionOfInterest.y1 * mProxyScale)),
+			static_cast<int32_t>(std::ceil(mRegionOfInterest.x2 * mProxyScale)),
+			static_cast<int32_t>(std::ceil(mRegionOfInterest.y2 * mProxyScale)) });
+	}
+
+	//nothing changed, a pixel is still read back so that every frame is written
+	if (region.getWidth() <= 0 || region.getHeight() <= 0)
+	{
+		int32_t x = std::min(std::max(region.x1, 0), getWidth() - 1);
+		int32_t y = std::min(std::max(region.y1, 0), getHeight() - 1);
+		region = cinder::Area{ x, y, x + 1, y + 1 };
+	}
+
+	return region;
+}
+
+CameraAE::Parameter AppAE::getCameraParameterAt(float frame) const
+{
+	assert(mState == State::Render && mUseCamera);
+
+	uint32_t first, second;
+	float t;
+	splitFrame(frame, &first, &second, &t);
+
+	return scaleCamera(CameraAE::interpolate(mCameraGetters[first], mCameraGetters[second], t), mProxyScale);
+}
+
+void AppAE::splitFrame(float frame, uint32_t *first, uint32_t *second, float *t) const
+{
+	float last = static_cast<float>(mDuration - 1);
+	frame = frame < 0.f ? 0.f : frame > last ? last : frame;
+
+	*first = static_cast<uint32_t>(frame);
+	*second = *first + 1 < mDuration ? *first + 1 : *first;
+	*t = frame - *first;
+}
+
+void AppAE::setParameter(const std::string &name, ParameterType type, ParameterValue value, uint32_t frame)
+{
+	setParameter(getSetterHandle(name, type), value, frame);
+}
+
+cinder::Surface AppAE::getLayerSurface(uint32_t frame)
+{
+	if (mLayerChannelName.empty())
+	{
+		return cinder::Surface{};
+	}
+
+	if (static_cast<int32_t>(frame) == mLayerFrame)
+	{
+		return mLayerSurface;
+	}
+
+	//a frame which already timed out is not waited for again
+	if (static_cast<int32_t>(frame) == mMissedLayerFrame)
+	{
+		return cinder::Surface{};
+	}
+
+	//the panel may create the channel after setup
+	if (!mLayerChannel)
+	{
+		mLayerChannel = FrameChannel::open(mLayerChannelName);
+		if (!mLayerChannel)
+		{
+			return cinder::Surface{};
+		}
+	}
+
+	//a new surface per frame, the app may still hold the surface of an earlier frame
+	cinder::Surface surface;
+	if (!mLayerChannel->read(frame, &surface, LAYER_TIMEOUT))
+	{
+		mMissedLayerFrame = static_cast<int32_t>(frame);
+		++mNumMissedLayerFrames;
+		console() << "layer: frame " << frame << " did not arrive within " << LAYER_TIMEOUT << " s" << std::endl;
+		return cinder::Surface{};
+	}
+	mLayerSurface = surface;
+	mLayerFrame = static_cast<int32_t>(frame);
+
+	return mLayerSurface;
+}
+
+cinder::gl::TextureRef AppAE::getLayerTexture(uint32_t frame)
+{
+	cinder::Surface surface = getLayerSurface(frame);
+	if (!surface.getData())
+	{
+		return nullptr;
+	}
+
+	if (!mLayerStreamer)
+	{
+		mLayerStreamer.reset(new TextureStreamer{});
+	}
+
+	return mLayerStreamer->update(surface);
+}
+
+SetterHandle AppAE::getSetterHandle(const std::string &name, ParameterType type)
+{
+	auto it = mSetterIds.find(name);
+	if (it != mSetterIds.end())
+	{
+		assert(mSetters[it->second].type == type);
+		return SetterHandle{ it->second };
+	}
+
+	uint32_t id = static_cast<uint32_t>(mSetters.size());
+	auto tolerance = mTolerances.find(name);
+	mSetters.push_back(Setter{ id, name, type, tolerance != mTolerances.end() ? tolerance->second : -1.f });
+	mSetterIds.insert(std::make_pair(name, id));
+
+	auto &setter = mSetters.back();
+	setter.values.resize(mDuration);
+	setter.states.resize(mDuration, Setter::EMPTY);
+
+	return SetterHandle{ id };
+}
+
+void AppAE::setParameter(SetterHandle handle, ParameterValue value, uint32_t frame)
+{
+	assert(mState == State::Render && handle.id < mSetters.size() && mSetters[handle.id].type != ParameterType::FloatArray);
+
+	//a sub-frame must not overwrite the value of its frame
+	if (mDrawingSubFrames)
+	{
+		return;
+	}
+
+	auto &setter = mSetters[handle.id];
+
+	//slots are reserved for the whole duration, this only grows for frames beyond it
+	if (frame >= setter.values.size())
+	{
+		setter.values.resize(frame + 1);
+		setter.states.resize(frame + 1, Setter::EMPTY);
+	}
+
+	//the last value set for a frame wins, baked in layer pixels
+	setter.values[frame] = scaleParameter(setter.type, value, 1.f / mProxyScale);
+
+	if (mStream && setter.states[frame] != Setter::PENDING)
+	{
+		setter.pending.push_back(frame);
+	}
+	setter.states[frame] = Setter::PENDING;
+}
+
+void AppAE::setParameterTolerance(const std::string &name, float tolerance)
+{
+	mTolerances[name] = tolerance;
+
+	auto it = mSetterIds.find(name);
+	if (it != mSetterIds.end())
+	{
+		mSetters[it->second].tolerance = tolerance;
+	}
+}
+
+void AppAE::setCameraParameter(const cinder::Camera &camera)
+{
+	assert(mState == State::Render);
+
+	if (mDrawingSubFrames)
+	{
+		return;
+	}
+
+	CameraAE::Parameter parameter = scaleCamera(CameraAE::Parameter{ camera.getFov(), camera.getInverseViewMatrix() }, 1.f / mProxyScale);
+
+	if (mStream)
+	{
+		mCameraStream[mCurrentFrame] = parameter;
+	}
+	else
+	{
+		mCameraSetterFrames.push_back(mCurrentFrame);
+		mCameraSetters.push_back(parameter);
 	}
+}
 
-	const auto it = mGetters.find(name);
-	const auto &getter = it->second;
-
-	return getter.values[frame];
+std::string AppAE::getImagePath(uint32_t frame) const
+{
+	return mPath + "/" + mFileName + "_" + zfill(frame, 5) + ".png";
 }
 
-CameraAE::Parameter AppAE::getCameraParameter(uint32_t frame) const
+void AppAE::loadEncoderPresets()
 {
-	assert(mState == State::Render && mUseCamera);
+	mEncoderPresets.clear();
+	mEncoderPresets[DEFAULT_ENCODER_PRESET] = DEFAULT_ENCODER_COMMAND;
 
-	if (frame >= mDuration)
+	auto &argv = getCommandLineArgs();
+	if (argv.empty())
 	{
-		frame = mDuration - 1;
+		return;
 	}
 
-	return mCameraGetters[frame];
+	cinder::fs::path presetsPath = cinder::fs::system_complete(argv[0]).parent_path() / ENCODER_PRESETS_FILE;
+	std::ifstream ifs{ presetsPath.string() };
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		std::size_t pos = line.find('=');
+		if (line.empty() || line[0] == '#' || pos == std::string::npos || pos == 0)
+		{
+			continue;
+		}
+		mEncoderPresets[line.substr(0, pos)] = line.substr(pos + 1);
+	}
+	console() << "encoder: " << mEncoderPresets.size() << " presets" << std::endl;
 }
 
-void AppAE::setParameter(const std::string &name, ParameterType type, ParameterValue value, uint32_t frame)
+std::string AppAE::getEncoderPreset() const
 {
-	assert(mState == State::Render);
+	auto it = mEncoderPresets.find(mEncoderName.empty() ? DEFAULT_ENCODER_PRESET : mEncoderName);
+	return it != mEncoderPresets.end() ? it->second : std::string{};
+}
 
-	if (mSetters.count(name) == 0)
+std::string AppAE::getEncoderCommand(const std::string &preset) const
+{
+	std::string output;
+	if (!quoteArgument(getMoviePath(), output))
 	{
-		mSetters.insert(std::make_pair(name, Setter{ static_cast<uint32_t>(mSetters.size()), name, type }));
+		return std::string{};
 	}
 
-	mSetters[name].values.push_back(std::make_pair(frame, value));
-}
+	cinder::ivec2 size = useFbo() ? mRenderTarget->getSize() : getWindowSize();
 
-void AppAE::setCameraParameter(const cinder::Camera &camera)
-{
-	assert(mState == State::Render);
+	std::string command = preset;
+	replaceAll(command, "{width}", std::to_string(size.x));
+	replaceAll(command, "{height}", std::to_string(size.y));
+	replaceAll(command, "{fps}", std::to_string(mFps));
+	replaceAll(command, "{output}", output);
 
-	mCameraSetters.push_back(std::make_pair(mCurrentFrame, CameraAE::Parameter{ camera.getFov(), camera.getInverseViewMatrix() }));
+	return command;
 }
 
 bool AppAE::useFbo() const
@@ -311,8 +966,9 @@ void AppAE::transition(State state)
 	switch (state)
 	{
 		case State::Setup:
+			mCameraSetterFrames.clear();
 			mCameraSetters.clear();
-			mSetters.clear();
+			mCameraStream.clear();
 			break;
 		case State::Render:
 			getWindow()->setAlwaysOnTop(true);
@@ -321,18 +977,93 @@ void AppAE::transition(State state)
 			{
 				mWriter.setFlip(false);
 				setWindowSize({ 640, 360 });
-				mFbo = cinder::gl::Fbo::create(mWidth, mHeight, cinder::gl::Fbo::Format{}.samples(16));
-				auto area = mFbo->getBounds();
-				cinder::gl::viewport(std::make_pair(cinder::ivec2{ 0, 0 }, area.getSize()));
-				cinder::gl::setMatricesWindow(mFbo->getSize());
+				mRenderTarget.reset(new RenderTarget{ cinder::ivec2{ getWidth(), getHeight() }, mSamples, mSupersample, RenderTarget::parseFilter(mResolveFilter) });
+				mAccumulationFbo.reset();
+				if (isMotionBlurred())
+				{
+					mAccumulationFbo = cinder::gl::Fbo::create(getWidth(), getHeight(), cinder::gl::Fbo::Format{}.colorTexture(cinder::gl::Texture2d::Format{}.internalFormat(GL_RGBA32F)).disableDepth());
+				}
+				//apps keep drawing in layer pixels when supersampled
+				cinder::gl::viewport(std::make_pair(cinder::ivec2{ 0, 0 }, mRenderTarget->getRenderFbo()->getSize()));
+				cinder::gl::setMatricesWindow(mRenderTarget->getSize());
+				console() << "fbo: " << getWidth() << "x" << getHeight() << ", " << mRenderTarget->getDescription() << std::endl;
 			}
 			else
 			{
 				mWriter.setFlip(true);
-				setWindowSize({ mWidth, mHeight });
+				setWindowSize({ getWidth(), getHeight() });
+			}
+
+			//the channel is recreated since the size may have changed
+			mOutputChannel.reset();
+			mSink.reset();
+			mOutputPath.clear();
+			if (mWrite && !mOutputChannelName.empty())
+			{
+				cinder::ivec2 size = useFbo() ? mRenderTarget->getSize() : getWindowSize();
+				mOutputChannel = FrameChannel::create(mOutputChannelName, size.x, size.y, OUTPUT_CHANNEL_SLOTS);
+				if (mOutputChannel)
+				{
+					mSink = std::make_shared<ChannelSink>(mOutputChannel);
+				}
+			}
+			else if (mWrite && mSinkName == "container")
+			{
+				auto sink = std::make_shared<ContainerSink>(getContainerPath());
+				if (sink->isOpen())
+				{
+					mSink = sink;
+					mOutputPath = getContainerPath();
+				}
+			}
+			else if (mWrite && mSinkName == "pipe")
+			{
+				//only the presets of this machine are run, the panel just names one
+				std::string preset = getEncoderPreset();
+				std::string command = preset.empty() ? std::string{} : getEncoderCommand(preset);
+				if (preset.empty())
+				{
+					console() << "encoder: \"" << mEncoderName << "\" is not a known preset" << std::endl;
+				}
+				else if (command.empty())
+				{
+					console() << "encoder: the output path cannot be passed to the shell" << std::endl;
+				}
+				else
+				{
+					auto sink = std::make_shared<PipeSink>(command);
+					if (sink->isOpen())
+					{
+						mSink = sink;
+						//the encoder may write somewhere else, or nowhere
+						bool hasOutput = preset.find("{output}") != std::string::npos;
+						mOutputPath = hasOutput ? getMoviePath() : std::string{};
+					}
+				}
+			}
+			else if (mWrite && mSinkName == "null")
+			{
+				mSink = std::make_shared<NullSink>();
+			}
+
+			//png files, also when the requested sink could not be opened
+			if (mWrite && !mSink)
+			{
+				if (!mOutputChannelName.empty() || mSinkName == "container" || mSinkName == "pipe")
+				{
+					console() << "sink: the requested output could not be opened, writing png files instead" << std::endl;
+				}
+				mOutputPath = getImagePath(0);
 			}
+			mWriter.setSink(mSink);
+
+			resetSetters();
 
 			mCurrentFrame = 0;
+			mDrawSeconds = 0.0;
+			mReadSeconds = 0.0;
+			mMissedLayerFrame = -1;
+			mNumMissedLayerFrames = 0;
 			timelineAE().clear();
 			timelineAE().stepTo(0.f);
 			setupAE();
@@ -341,6 +1072,9 @@ void AppAE::transition(State state)
 		case State::Setdown:
 			getWindow()->setAlwaysOnTop(false);
 			setdown();
+			mLayerChannel.reset();
+			mLayerFrame = -1;
+			mMissedLayerFrame = -1;
 			break;
 	}
 }
@@ -356,11 +1090,44 @@ void AppAE::setdown()
 		std::this_thread::sleep_for(std::chrono::seconds(1));
 	}
 
-	//setdown
-	static const int MAX_CAMERA_ARG_NUM = 30;
-	static const int MAX_ARG_NUM = 150;
+	if (mSink)
+	{
+		mSink->close();
+		//what was written is incomplete, so it is not reported as the output
+		if (mSink->hasFailed())
+		{
+			console() << "sink: writing failed, the output is incomplete" << std::endl;
+			mOutputPath.clear();
+		}
+	}
 
 	if (mWrite)
+	{
+		console() << "duplicates: " << mWriter.getNumDuplicates() << " frames" << std::endl;
+	}
+
+	if (mOutputChannel && mOutputChannel->getDroppedCount() > 0)
+	{
+		console() << "output channel: " << mOutputChannel->getDroppedCount() << " frames overwritten before the reader read them" << std::endl;
+	}
+
+	if (mNumMissedLayerFrames > 0)
+	{
+		console() << "layer: " << mNumMissedLayerFrames << " frames missed" << std::endl;
+	}
+
+	//the average per frame, the readback includes waiting for the GPU
+	double drawMilliseconds = mCurrentFrame > 0 ? mDrawSeconds * 1000.0 / mCurrentFrame : 0.0;
+	double readMilliseconds = mCurrentFrame > 0 ? mReadSeconds * 1000.0 / mCurrentFrame : 0.0;
+	console() << (useFbo() ? mRenderTarget->getDescription() : std::string{ "window" }) << ": draw " << drawMilliseconds << " ms, readback " << readMilliseconds << " ms per frame" << std::endl;
+
+	//setdown
+	if (mWrite && mStream)
+	{
+		//only the remainder has not been sent yet
+		streamSetters(true);
+	}
+	else if (mWrite)
 	{
 		if (!mCameraSetters.empty())
 		{
@@ -376,6 +1143,10 @@ void AppAE::setdown()
 				mSender.send(reply);
 			}
 
+			//convert all frames at once before packing
+			CameraAE::Transforms transforms;
+			CameraAE::toTransforms(mCameraSetters, static_cast<float>(mHeight), &transforms, static_cast<int>(std::thread::hardware_concurrency()));
+
 			for (int i = 0, n = 0; i < valueSize; i += MAX_CAMERA_ARG_NUM, ++n)
 			{
 				cinder::osc::Message reply;
@@ -384,77 +1155,51 @@ void AppAE::setdown()
 
 				for (int j = 0, total = std::min(MAX_CAMERA_ARG_NUM, valueSize - i); j < total; ++j)
 				{
-					auto &pair = mCameraSetters[i + j];
-					auto frame = pair.first;
-					auto &value = pair.second;
-					float fov = cinder::toRadians(value.fov);
-					auto cameraMatrix = value.cameraMatrix;
-					cameraMatrix = cinder::scale(cameraMatrix, cinder::vec3{ 1.f, -1.f, -1.f });
-
-					//calc position
-					cinder::vec3 position{ cameraMatrix[0][3], cameraMatrix[1][3], cameraMatrix[2][3] };
-
-					//calc orientation
-					cinder::vec3 orientation{};
-					{
-						orientation.y = std::asin(cameraMatrix[0][2]);
-
-						float cosY = std::cos(orientation.y);
-						if (cosY != 0.f)
-						{
-							orientation.x = std::atan2(-cameraMatrix[1][2], cameraMatrix[2][2]);
-							orientation.z = std::asin(-cameraMatrix[0][1] / cosY);
-							if (cameraMatrix[0][0] < 0.f)
-							{
-								orientation.z = static_cast<float>(M_PI)-orientation.z;
-							}
-						}
-						else
-						{
-							orientation.x = std::atan2(cameraMatrix[2][1], cameraMatrix[1][1]);
-							orientation.y = 0.5f * static_cast<float>(M_PI);
-							orientation.z = 0.f;
-						}
-
-						orientation *= 57.295779513082321f; // ( x * 180 / PI )
-					}
-
-					//calc zoom
-					float zoom = getHeight() / (2.f * std::tan(fov / 2.f));
+					int k = i + j;
 
 					//add args
-					reply.append(frame);
-					reply.append(position.x);
-					reply.append(position.y);
-					reply.append(position.z);
-					reply.append(orientation.x);
-					reply.append(orientation.y);
-					reply.append(orientation.z);
-					reply.append(zoom);
+					reply.append(mCameraSetterFrames[k]);
+					reply.append(transforms.positionX[k]);
+					reply.append(transforms.positionY[k]);
+					reply.append(transforms.positionZ[k]);
+					reply.append(transforms.orientationX[k]);
+					reply.append(transforms.orientationY[k]);
+					reply.append(transforms.orientationZ[k]);
+					reply.append(transforms.zoom[k]);
 				}
 
 				mSender.send(reply);
 			}
 		}
 
-		std::vector<Setter*> setters;
-		for (auto &pair : mSetters)
+		//setters are stored in the order they were added
+		for (auto &setter : mSetters)
 		{
-			setters.push_back(&pair.second);
-		}
+			auto &name = setter.name;
+			ParameterType type = setter.type;
 
-		std::sort(setters.begin(), setters.end(), [](const Setter *lhs, const Setter *rhs) -> bool {
-			return lhs->id < rhs->id;
-		});
+			//the slots are already in frame order
+			std::vector<Setter::Value> values;
+			for (std::size_t frame = 0; frame < setter.states.size(); ++frame)
+			{
+				if (setter.states[frame] != Setter::EMPTY)
+				{
+					values.push_back(std::make_pair(static_cast<int32_t>(frame), setter.values[frame]));
+				}
+			}
+
+			if (values.empty())
+			{
+				continue;
+			}
+
+			if (setter.tolerance >= 0.f)
+			{
+				std::size_t recorded = values.size();
+				simplifyValues(type, setter.tolerance, values);
+				console() << name << ": " << values.size() << " / " << recorded << " keyframes" << std::endl;
+			}
 
-		for (auto &setter : setters)
-		{
-			auto &name = setter->name;
-			ParameterType type = setter->type;
-			auto &values = setter->values;
-			std::sort(values.begin(), values.end(), [](const Setter::Value &lhs, const Setter::Value &rhs) -> bool {
-				return lhs.first < rhs.first;
-			});
 			int valueSize = static_cast<int>(values.size());
 			std::string prefix = "/cinder/setdown/" + name + "/";
 
@@ -492,9 +1237,8 @@ void AppAE::setdown()
 		cinder::osc::Message reply;
 		reply.setAddress("/cinder/renderend");
 
-		//path
-		std::string sequencePath = mPath + "/" + mFileName + "_" + zfill(0, 5) + ".png";
-		reply.append(sequencePath);
+		//path of the sink actually used, empty when no file was written
+		reply.append(mOutputPath);
 
 		//executable path
 		auto &argv = getCommandLineArgs();
@@ -507,12 +1251,138 @@ void AppAE::setdown()
 		//source time
 		reply.append(mSourceTime);
 
+		//output channel, empty when the frames were written to files
+		reply.append(mOutputChannel ? mOutputChannelName : std::string{});
+
+		//unchanged frames which were repeated instead of encoded
+		reply.append(static_cast<int32_t>(mWriter.getNumDuplicates()));
+
+		//the fbo settings actually used, after clamping
+		reply.append(static_cast<int32_t>(useFbo() ? mRenderTarget->getSamples() : 0));
+		reply.append(static_cast<int32_t>(useFbo() ? mRenderTarget->getFactor() : 1));
+
+		//milliseconds per frame
+		reply.append(static_cast<float>(drawMilliseconds));
+		reply.append(static_cast<float>(readMilliseconds));
+
+		//layer frames which did not arrive in time, the app got an empty surface for them
+		reply.append(static_cast<int32_t>(mNumMissedLayerFrames));
+
 		mSender.send(reply);
 	}
 
 	transition(State::Setup);
 }
 
+void AppAE::streamSetters(bool flush)
+{
+	//a few messages per frame, so that streaming does not stall rendering, unless the app sets values faster than that drains them
+	//each message holds one setter's frames in ascending order, a frame set again after it was sent goes out again in a later message and the panel's last write wins
+	int backlog = static_cast<int>(mCameraStream.size() / MAX_CAMERA_ARG_NUM);
+	for (const auto &setter : mSetters)
+	{
+		backlog += static_cast<int>(setter.pending.size() / MAX_ARG_NUM);
+	}
+
+	int budget = flush ? std::numeric_limits<int>::max() : std::max(MAX_STREAM_MESSAGES_PER_FRAME, backlog - MAX_STREAM_BACKLOG);
+
+	while (budget > 0 && !mCameraStream.empty() && (flush || mCameraStream.size() >= MAX_CAMERA_ARG_NUM))
+	{
+		std::vector<int32_t> frames;
+		std::vector<CameraAE::Parameter> parameters;
+		for (auto it = mCameraStream.begin(); it != mCameraStream.end() && frames.size() < MAX_CAMERA_ARG_NUM; it = mCameraStream.erase(it))
+		{
+			frames.push_back(it->first);
+			parameters.push_back(it->second);
+		}
+
+		CameraAE::Transforms transforms;
+		CameraAE::toTransforms(parameters, static_cast<float>(mHeight), &transforms);
+
+		cinder::osc::Message reply;
+		reply.setAddress("/cinder/stream/cameraAE");
+		reply.append("camera");
+
+		for (std::size_t i = 0; i < frames.size(); ++i)
+		{
+			reply.append(frames[i]);
+			reply.append(transforms.positionX[i]);
+			reply.append(transforms.positionY[i]);
+			reply.append(transforms.positionZ[i]);
+			reply.append(transforms.orientationX[i]);
+			reply.append(transforms.orientationY[i]);
+			reply.append(transforms.orientationZ[i]);
+			reply.append(transforms.zoom[i]);
+		}
+
+		mSender.send(reply);
+		--budget;
+	}
+
+	//start with a different setter each frame, so that busy setters do not starve the ones after them
+	std::size_t numSetters = mSetters.size();
+	for (std::size_t n = 0; n < numSetters; ++n)
+	{
+		auto &setter = mSetters[(mStreamSetterOffset + n) % numSetters];
+		auto &pending = setter.pending;
+
+		if (budget > 0 && !pending.empty() && (flush || pending.size() >= MAX_ARG_NUM))
+		{
+			std::sort(pending.begin(), pending.end());
+		}
+
+		std::size_t first = 0;
+		while (budget > 0 && first < pending.size() && (flush || pending.size() - first >= MAX_ARG_NUM))
+		{
+			std::size_t last = std::min(pending.size(), first + MAX_ARG_NUM);
+
+			std::vector<Setter::Value> values;
+			for (std::size_t i = first; i < last; ++i)
+			{
+				int32_t frame = pending[i];
+				values.push_back(std::make_pair(frame, setter.values[frame]));
+				setter.states[frame] = Setter::SENT;
+			}
+			first = last;
+
+			if (setter.tolerance >= 0.f)
+			{
+				simplifyValues(setter.type, setter.tolerance, values);
+			}
+
+			cinder::osc::Message reply;
+			reply.setAddress("/cinder/stream/" + setter.name);
+			reply.append(parmeterTypeToString(setter.type));
+
+			for (auto &value : values)
+			{
+				reply.append(value.first);
+				addValueToMessage(reply, setter.type, value.second);
+			}
+
+			mSender.send(reply);
+			--budget;
+		}
+
+		pending.erase(pending.begin(), pending.begin() + first);
+	}
+
+	if (numSetters > 0)
+	{
+		mStreamSetterOffset = (mStreamSetterOffset + 1) % numSetters;
+	}
+}
+
+void AppAE::resetSetters()
+{
+	for (auto &setter : mSetters)
+	{
+		setter.values.assign(mDuration, ParameterValue{});
+		setter.states.assign(mDuration, Setter::EMPTY);
+		setter.pending.clear();
+	}
+}
+
 void AppAE::processMessage(const cinder::osc::Message &message)
 {
 	auto paths = cinder::split(message.getAddress(), '/');
@@ -597,6 +1467,88 @@ void AppAE::processSetupMessage(const cinder::osc::Message &message, const std::
 		mSourceTime = sourceTime;
 	}
 
+	//optional, older panels do not send it
+	if (message.getNumArgs() > SETUP_ARG_STREAM)
+	{
+		int32_t stream = message.getArgInt32(SETUP_ARG_STREAM);
+		mStream = stream ? true : false;
+	}
+
+	//optional, the name of the shared memory the panel writes the layer frames to
+	if (message.getNumArgs() > SETUP_ARG_LAYER)
+	{
+		std::string layerChannelName = message.getArgString(SETUP_ARG_LAYER);
+		if (layerChannelName != mLayerChannelName)
+		{
+			mLayerChannel.reset();
+			mLayerFrame = -1;
+			mMissedLayerFrame = -1;
+		}
+		mLayerChannelName = layerChannelName;
+	}
+
+	//optional, the name of the shared memory to publish the frames to instead of writing files
+	if (message.getNumArgs() > SETUP_ARG_OUTPUT)
+	{
+		mOutputChannelName = message.getArgString(SETUP_ARG_OUTPUT);
+	}
+
+	//optional, "container" appends the raw frames to a single file, "pipe" streams them to an encoder and "null" discards them
+	if (message.getNumArgs() > SETUP_ARG_SINK)
+	{
+		mSinkName = message.getArgString(SETUP_ARG_SINK);
+	}
+
+	//optional, the name of the encoder preset for "pipe"(empty means h264 with ffmpeg)
+	if (message.getNumArgs() > SETUP_ARG_ENCODER)
+	{
+		mEncoderName = message.getArgString(SETUP_ARG_ENCODER);
+	}
+
+	//optional, the number of sub-frames to accumulate for motion blur(it needs the fbo)
+	if (message.getNumArgs() > SETUP_ARG_MOTIONBLUR)
+	{
+		int32_t motionBlurSamples = message.getArgInt32(SETUP_ARG_MOTIONBLUR);
+		mMotionBlurSamples = motionBlurSamples > 1 ? motionBlurSamples : 1;
+	}
+
+	//optional, the shutter angle and phase in degrees as After Effects' composition settings
+	if (message.getNumArgs() > SETUP_ARG_SHUTTERPHASE)
+	{
+		mShutterAngle = message.getArgFloat(SETUP_ARG_SHUTTERANGLE);
+		mShutterPhase = message.getArgFloat(SETUP_ARG_SHUTTERPHASE);
+	}
+
+	//optional, the samples per pixel of the fbo(clamped to GL_MAX_SAMPLES)
+	if (message.getNumArgs() > SETUP_ARG_SAMPLES)
+	{
+		mSamples = message.getArgInt32(SETUP_ARG_SAMPLES);
+	}
+
+	//optional, renders the fbo this many times larger and filters it down with "box" or "lanczos"
+	if (message.getNumArgs() > SETUP_ARG_RESOLVE)
+	{
+		mSupersample = message.getArgInt32(SETUP_ARG_SUPERSAMPLE);
+		mResolveFilter = message.getArgString(SETUP_ARG_RESOLVE);
+	}
+
+	//optional, the scale of a draft render as After Effects' Half, Third or Quarter resolution
+	if (message.getNumArgs() > SETUP_ARG_PROXY)
+	{
+		float proxyScale = message.getArgFloat(SETUP_ARG_PROXY);
+		mProxyScale = proxyScale > 0.f && proxyScale < 1.f ? proxyScale : 1.f;
+	}
+
+	//optional, the region of interest in layer pixels(an empty one means the whole layer)
+	if (message.getNumArgs() > SETUP_ARG_REGION_HEIGHT)
+	{
+		int32_t regionX = message.getArgInt32(SETUP_ARG_REGION_X);
+		int32_t regionY = message.getArgInt32(SETUP_ARG_REGION_Y);
+		int32_t regionWidth = message.getArgInt32(SETUP_ARG_REGION_WIDTH);
+		int32_t regionHeight = message.getArgInt32(SETUP_ARG_REGION_HEIGHT);
+		mRegionOfInterest = regionWidth > 0 && regionHeight > 0 ? cinder::Area{ regionX, regionY, regionX + regionWidth, regionY + regionHeight } : cinder::Area{ 0, 0, 0, 0 };
+	}
+
 	//reply
 	cinder::osc::Message reply;
 	reply.setAddress(message.getAddress());
@@ -620,7 +1572,20 @@ void AppAE::processSetupMessage(const cinder::osc::Message &message, const std::
 	{
 		reply.append(getter->name);
 		reply.append(parmeterTypeToString(getter->type));
-		addValueToMessage(reply, getter->type, getter->initialValue);
+
+		if (getter->type == ParameterType::FloatArray)
+		{
+			addArrayToMessage(reply, getter->initialArray);
+		}
+		else
+		{
+			addValueToMessage(reply, getter->type, getter->initialValue);
+		}
+
+		if (getter->type == ParameterType::Popup)
+		{
+			reply.append(joinOptions(getter->options));
+		}
 	}
 
 	mSender.send(reply);
@@ -688,6 +1653,7 @@ void AppAE::processPrerenderMessage(const cinder::osc::Message &message, const s
 			if (times == "begin")
 			{
 				values.clear();
+				parameter.arrayValues.clear();
 			}
 
 			switch (type) {
@@ -736,6 +1702,58 @@ void AppAE::processPrerenderMessage(const cinder::osc::Message &message, const s
 						values.push_back(value);
 					}
 					break;
+				case ParameterType::Angle:
+					for (int i = 0; i < argNum; ++i)
+					{
+						ParameterValue value;
+						value.angle.value = message.getArgFloat(i);
+						values.push_back(value);
+					}
+					break;
+				case ParameterType::Integer:
+					for (int i = 0; i < argNum; ++i)
+					{
+						ParameterValue value;
+						value.integer.value = message.getArgInt32(i);
+						values.push_back(value);
+					}
+					break;
+				case ParameterType::Popup:
+					for (int i = 0; i < argNum; ++i)
+					{
+						ParameterValue value;
+						value.popup.value = message.getArgInt32(i);
+						values.push_back(value);
+					}
+					break;
+				case ParameterType::ColorA:
+					for (int i = 0; i < argNum; i += 4)
+					{
+						ParameterValue value;
+						value.colorA.r = message.getArgFloat(i);
+						value.colorA.g = message.getArgFloat(i + 1);
+						value.colorA.b = message.getArgFloat(i + 2);
+						value.colorA.a = message.getArgFloat(i + 3);
+						values.push_back(value);
+					}
+					break;
+				case ParameterType::FloatArray:
+				{
+					//each frame is the number of floats followed by the floats, stored back to back
+					auto &arrayValues = parameter.arrayValues;
+					for (int i = 0; i < argNum;)
+					{
+						int32_t count = message.getArgInt32(i++);
+						ParameterValue value;
+						value.integer.value = static_cast<int32_t>(arrayValues.size());
+						for (int j = 0; j < count && i < argNum; ++j)
+						{
+							arrayValues.push_back(message.getArgFloat(i++));
+						}
+						values.push_back(value);
+					}
+					break;
+				}
 			}
 
 			if (times == "last")
@@ -757,15 +1775,89 @@ void AppAE::processPrerenderMessage(const cinder::osc::Message &message, const s
 	mSender.send(reply);
 }
 
+float AppAE::getSubFrameOffset(int32_t sample) const
+{
+	if (!isMotionBlurred())
+	{
+		return 0.f;
+	}
+
+	//the samples are centered in the open shutter, as After Effects does
+	return (mShutterPhase + mShutterAngle * (sample + 0.5f) / mMotionBlurSamples) / 360.f;
+}
+
+void AppAE::drawMotionBlur()
+{
+	const float weight = 1.f / mMotionBlurSamples;
+	const cinder::gl::FboRef &renderFbo = mRenderTarget->getRenderFbo();
+	const cinder::gl::FboRef &outputFbo = mRenderTarget->getOutputFbo();
+	const cinder::ivec2 size = mRenderTarget->getSize();
+	const auto renderScissor = mRenderTarget->getRenderScissor(mFrameRegion);
+	const cinder::ivec2 outputScissor{ mFrameRegion.x1, size.y - mFrameRegion.y2 };
+
+	//each sub-frame is drawn into the fbo as usual, then resolved and added to the float fbo
+	//updateAE() has run once for the frame, only the time, the parameters and the timeline follow the sub-frames
+	mDrawingSubFrames = true;
+	{
+		cinder::gl::ScopedFramebuffer scopedAccumulation{ mAccumulationFbo };
+		cinder::gl::ScopedScissor scopedAccumulationScissor{ outputScissor, mFrameRegion.getSize() };
+		cinder::gl::clear(cinder::ColorA{ 0.f, 0.f, 0.f, 0.f });
+
+		for (int32_t sample = 0; sample < mMotionBlurSamples; ++sample)
+		{
+			//completed tweens are kept, since the sub-frames may go back and forth around the frame
+			mSubFrame = getSubFrameOffset(sample);
+			timelineAE().evaluateAt(getCurrentTime());
+
+			{
+				cinder::gl::ScopedFramebuffer scopedFrameBuffer{ renderFbo };
+				cinder::gl::ScopedScissor scopedScissor{ renderScissor.first, renderScissor.second };
+				drawAE();
+			}
+			mRenderTarget->resolve(mFrameRegion);
+
+			cinder::gl::ScopedViewport scopedViewport{ cinder::ivec2{ 0, 0 }, size };
+			cinder::gl::ScopedMatrices scopedMatrices;
+			cinder::gl::setMatricesWindow(size);
+			cinder::gl::ScopedDepth scopedDepth{ false };
+			cinder::gl::ScopedBlend scopedBlend{ GL_ONE, GL_ONE };
+			cinder::gl::ScopedColor scopedColor{ weight, weight, weight, weight };
+			cinder::gl::draw(outputFbo->getColorTexture(), mAccumulationFbo->getBounds());
+		}
+	}
+
+	mDrawingSubFrames = false;
+	mSubFrame = 0.f;
+	timelineAE().evaluateAt(getCurrentTime());
+
+	//the average replaces the output fbo, so that writing images is the same as without motion blur
+	cinder::gl::ScopedFramebuffer scopedFrameBuffer{ outputFbo };
+	cinder::gl::ScopedViewport scopedViewport{ cinder::ivec2{ 0, 0 }, size };
+	cinder::gl::ScopedScissor scopedScissor{ outputScissor, mFrameRegion.getSize() };
+	cinder::gl::ScopedMatrices scopedMatrices;
+	cinder::gl::setMatricesWindow(size);
+	cinder::gl::ScopedDepth scopedDepth{ false };
+	cinder::gl::ScopedBlend scopedBlend{ false };
+	cinder::gl::draw(mAccumulationFbo->getColorTexture(), outputFbo->getBounds());
+}
+
 void AppAE::writeImage()
 {
-	std::string path = mPath + "/" + mFileName + "_" + zfill(mCurrentFrame, 5) + ".png";
+	std::string path = getImagePath(mCurrentFrame);
+
+	if (useFbo() && isCropped() && mSink && mSink->handlesCrop())
+	{
+		cinder::Surface surface = mRenderTarget->readPixels(mFrameRegion);
 
-	if (useFbo())
+		mWriter.pushImage(path, surface, mCurrentFrame, mFrameRegion.getUL(), getSize());
+	}
+	else if (useFbo())
 	{
-		cinder::Surface surface = mFbo->readPixels8u(mFbo->getBounds());
+		//the region has been drawn over the previous frame
+		const cinder::gl::FboRef &fbo = mRenderTarget->getOutputFbo();
+		cinder::Surface surface = fbo->readPixels8u(fbo->getBounds());
 
-		mWriter.pushImage(path, surface);
+		mWriter.pushImage(path, surface, mCurrentFrame);
 	}
 	else
 	{
@@ -782,7 +1874,7 @@ void AppAE::writeImage()
 		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, surface.getData());
 		glPixelStorei(GL_PACK_ALIGNMENT, oldPackAlignment);
 
-		mWriter.pushImage(path, surface);
+		mWriter.pushImage(path, surface, mCurrentFrame);
 	}
 
 
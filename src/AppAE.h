@@ -28,7 +28,11 @@
 #include "cinder/gl/Fbo.h"
 #include "Osc.h"
 #include "ImageWriter.h"
+#include "FrameChannel.h"
+#include "TextureStreamer.h"
+#include "RenderTarget.h"
 #include <map>
+#include <unordered_map>
 #include <queue>
 
 namespace atarabi {
@@ -58,33 +62,56 @@ protected:
 	float getFps() const override { return mFps; }
 	uint32_t getDuration() const override { return mDuration; }
 	uint32_t getCurrentFrame() const override { return mCurrentFrame; }
-	float getCurrentTime() const override { return mCurrentFrame / mFps; }
+	float getCurrentTime() const override { return (mCurrentFrame + mSubFrame) / mFps; }
+	float getSubFrame() const override { return mSubFrame; }
 
-	int getWidth() const override { return mWidth; }
-	int getHeight() const override { return mHeight; }
+	int getWidth() const override { return scaleLength(mWidth); }
+	int getHeight() const override { return scaleLength(mHeight); }
 	cinder::ivec2 getSize() const override { return useFbo() ? cinder::ivec2{ getWidth(), getHeight() } : getWindowSize(); };
+	float getProxyScale() const override { return mProxyScale; }
 
 	std::string getSourcePath() const override { return mSourcePath; }
 	float getSourceTime() const override { return mSourceTime; }
 
+	using IAppAE::getLayerSurface;
+	cinder::Surface getLayerSurface(uint32_t frame) override;
+	using IAppAE::getLayerTexture;
+	cinder::gl::TextureRef getLayerTexture(uint32_t frame) override;
+
 	using IAppAE::addParameter;
 	void addParameter(const std::string &name, ParameterType type, ParameterValue initialValue) override;
+	void addParameter(const std::string &name, const std::vector<std::string> &options, int32_t initialValue) override;
+	void addParameter(const std::string &name, const std::vector<float> &initialValue) override;
 
 	using IAppAE::getParameter;
 	ParameterValue getParameter(const std::string &name, uint32_t frame) const override;
+	ParameterValue getParameterAt(const std::string &name, float frame) const override;
+
+	using IAppAE::getArrayParameter;
+	std::vector<float> getArrayParameter(const std::string &name, uint32_t frame) const override;
 
 	using IAppAE::getCameraParameter;
 	CameraAE::Parameter getCameraParameter(uint32_t frame) const override;
+	CameraAE::Parameter getCameraParameterAt(float frame) const override;
 
 	using IAppAE::setParameter;
 	void setParameter(const std::string &name, ParameterType type, ParameterValue value, uint32_t frame) override;
 
+	SetterHandle getSetterHandle(const std::string &name, ParameterType type) override;
+	void setParameter(SetterHandle handle, ParameterValue value, uint32_t frame) override;
+
+	void setParameterTolerance(const std::string &name, float tolerance) override;
+
 	void setCameraParameter(const cinder::Camera &camera) override;
 
 	bool useFbo() const override;
 
 	void setUnmultiply(bool unmultiply) override { mWriter.setUnpremultiply(unmultiply); }
 
+	void setDeduplicate(bool deduplicate) override { mWriter.setDeduplicate(deduplicate); }
+
+	void setDirtyRect(const cinder::Area &area) override;
+
 private:
 	enum class State {
 		Uninitialized,
@@ -104,9 +131,33 @@ private:
 		SETUP_ARG_WIDTH,
 		SETUP_ARG_HEIGHT,
 		SETUP_ARG_SOURCE,
-		SETUP_ARG_SOURCETIME
+		SETUP_ARG_SOURCETIME,
+		SETUP_ARG_STREAM,
+		SETUP_ARG_LAYER,
+		SETUP_ARG_OUTPUT,
+		SETUP_ARG_SINK,
+		SETUP_ARG_ENCODER,
+		SETUP_ARG_MOTIONBLUR,
+		SETUP_ARG_SHUTTERANGLE,
+		SETUP_ARG_SHUTTERPHASE,
+		SETUP_ARG_SAMPLES,
+		SETUP_ARG_SUPERSAMPLE,
+		SETUP_ARG_RESOLVE,
+		SETUP_ARG_PROXY,
+		SETUP_ARG_REGION_X,
+		SETUP_ARG_REGION_Y,
+		SETUP_ARG_REGION_WIDTH,
+		SETUP_ARG_REGION_HEIGHT
 	};
 
+	static const int MAX_CAMERA_ARG_NUM = 30;
+	static const int MAX_ARG_NUM = 150;
+	//! A rate cap on streamed setter messages per rendered frame, not flow control: the panel acknowledges nothing.
+	static const int MAX_STREAM_MESSAGES_PER_FRAME = 4;
+	//! Batches allowed to wait; beyond this, a frame sends as many messages as it takes to get back under it.
+	static const int MAX_STREAM_BACKLOG = 64;
+	static const uint32_t OUTPUT_CHANNEL_SLOTS = 8;
+
 	struct Getter {
 		using Value = ParameterValue;
 		uint32_t id;
@@ -114,44 +165,101 @@ private:
 		ParameterType type;
 		ParameterValue initialValue;
 		std::vector<Value> values;
+		std::vector<std::string> options;
+		std::vector<float> initialArray;
+		std::vector<float> arrayValues;
 	};
 
 	struct Setter {
 		using Value = std::pair<int32_t, ParameterValue>;
+		enum State : uint8_t {
+			EMPTY,
+			PENDING,
+			SENT
+		};
 		uint32_t id;
 		std::string name;
 		ParameterType type;
-		std::vector<Value> values;
+		float tolerance;
+		std::vector<ParameterValue> values;
+		std::vector<uint8_t> states;
+		std::vector<int32_t> pending;
 	};
 
 	bool isParameterCached() const;
 	void transition(State state);
 	void setdown();
+	void resetSetters();
+	//! Sends full batches of streamed setter values, or everything when flush is true.
+	void streamSetters(bool flush);
 	void processMessage(const cinder::osc::Message &message);
 	void processSetupMessage(const cinder::osc::Message &message, const std::vector<std::string> &paths);
 	void processPrerenderMessage(const cinder::osc::Message &message, const std::vector<std::string> &paths);
+	void drawMotionBlur();
 	void writeImage();
+	bool isMotionBlurred() const { return useFbo() && mMotionBlurSamples > 1; }
+	float getSubFrameOffset(int32_t sample) const;
+	void splitFrame(float frame, uint32_t *first, uint32_t *second, float *t) const;
+	cinder::Area calcFrameRegion() const;
+	bool isCropped() const { return mFrameRegion != cinder::Area{ 0, 0, getWidth(), getHeight() }; }
+	//! Scales a length in layer pixels to the proxy resolution.
+	int scaleLength(int length) const { return length * mProxyScale > 1.f ? static_cast<int>(length * mProxyScale + 0.5f) : 1; }
+	std::string getImagePath(uint32_t frame) const;
+	std::string getContainerPath() const { return mPath + "/" + mFileName + ".frames"; }
+	std::string getMoviePath() const { return mPath + "/" + mFileName + ".mp4"; }
+	//! Reads the encoder presets, the built-in one and those of the file next to the executable.
+	void loadEncoderPresets();
+	//! Returns the command of the requested preset, or empty when it is unknown.
+	std::string getEncoderPreset() const;
+	//! Returns the command to run for preset, or empty when the output path cannot be quoted safely.
+	std::string getEncoderCommand(const std::string &preset) const;
 
 	State mState = State::Uninitialized;
 	uint32_t mCurrentFrame = 0;
+	float mSubFrame = 0.f;
+	//while drawAE() is called for the sub-frames of motion blur
+	bool mDrawingSubFrames = false;
 
-	cinder::gl::FboRef mFbo;
+	std::unique_ptr<RenderTarget> mRenderTarget;
+	cinder::gl::FboRef mAccumulationFbo;
+	//the part of the frame drawn and read back
+	cinder::Area mFrameRegion{ 0, 0, 0, 0 };
+	cinder::Area mDirtyRect{ 0, 0, 0, 0 };
+	bool mHasDirtyRect = false;
+	double mDrawSeconds = 0.0;
+	double mReadSeconds = 0.0;
 
 	std::vector<CameraAE::Parameter> mCameraGetters;
-	std::vector<std::pair<int32_t, CameraAE::Parameter>> mCameraSetters;
+	std::vector<int32_t> mCameraSetterFrames;
+	std::vector<CameraAE::Parameter> mCameraSetters;
+	std::map<int32_t, CameraAE::Parameter> mCameraStream;
+	std::size_t mStreamSetterOffset = 0;
 	std::map<std::string, Getter> mGetters;
-	std::map<std::string, Setter> mSetters;
+	std::vector<Setter> mSetters;
+	std::unordered_map<std::string, uint32_t> mSetterIds;
+	std::map<std::string, float> mTolerances;
 
 	cinder::osc::SenderUdp mSender;
 	cinder::osc::ReceiverUdp mReceiver;
 	std::queue<cinder::osc::Message> mMessages;
 	ImageWriter mWriter;
+	std::shared_ptr<FrameChannel> mLayerChannel;
+	cinder::Surface mLayerSurface;
+	int32_t mLayerFrame = -1;
+	int32_t mMissedLayerFrame = -1;
+	uint32_t mNumMissedLayerFrames = 0;
+	std::unique_ptr<TextureStreamer> mLayerStreamer;
+	std::shared_ptr<FrameChannel> mOutputChannel;
+	std::shared_ptr<ImageSink> mSink;
+	//the path reported at renderend, empty when the frames do not go to a file
+	std::string mOutputPath;
 
 	//from AE
 	std::string mPath;
 	std::string mFileName = "cinder";
 	bool mCache = false;
 	bool mWrite = false;
+	bool mStream = false;
 	bool mUseFbo = false;
 	float mFps = 30.f;
 	uint32_t mDuration = 1;
@@ -159,6 +267,19 @@ private:
 	int mHeight = 1;
 	std::string mSourcePath;
 	float mSourceTime = 0.f;
+	std::string mLayerChannelName;
+	std::string mOutputChannelName;
+	std::string mSinkName;
+	std::string mEncoderName;
+	std::map<std::string, std::string> mEncoderPresets;
+	int32_t mMotionBlurSamples = 1;
+	float mShutterAngle = 180.f;
+	float mShutterPhase = -90.f;
+	int32_t mSamples = 16;
+	int32_t mSupersample = 1;
+	std::string mResolveFilter;
+	float mProxyScale = 1.f;
+	cinder::Area mRegionOfInterest{ 0, 0, 0, 0 };
 };
 
 }
\ No newline at end of file
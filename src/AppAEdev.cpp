@@ -82,6 +82,7 @@ void AppAEdev::setupParams()
 	});
 	mParams->addParam("Fps", &mFps).min(1.f).max(60.f).updateFn([this]() -> void {
 		setFrameRate(mFps);
+		mLayerMovie.setCompFps(mFps);
 	});
 	mParams->addParam("SourcePath", &mSourcePath, true);
 	mParams->addButton("Open", [this]() -> void {
@@ -182,10 +183,52 @@ void AppAEdev::addParameter(const std::string &name, ParameterType type, Paramet
 				parameter.value.color = initialValue;
 				mParams->addParam(name, &parameter.value.color);
 				break;
+			case ParameterType::Angle:
+				parameter.value.angle = initialValue;
+				mParams->addParam(name, &parameter.value.angle).step(1.f);
+				break;
+			case ParameterType::Integer:
+				parameter.value.integer = initialValue;
+				mParams->addParam(name, &parameter.value.integer);
+				break;
+			case ParameterType::Popup:
+				//use addParameter(name, options, initialValue)
+				assert(0);
+				break;
+			case ParameterType::ColorA:
+				parameter.value.colorA = initialValue;
+				mParams->addParam(name, &parameter.value.colorA);
+				break;
+			case ParameterType::FloatArray:
+				//use addParameter(name, initialValue)
+				assert(0);
+				break;
 		}
 	}
 }
 
+void AppAEdev::addParameter(const std::string &name, const std::vector<std::string> &options, int32_t initialValue)
+{
+	if (mParameters.count(name) == 0)
+	{
+		const auto &pair = mParameters.insert(std::make_pair(name, Parameter{ name, ParameterType::Popup }));
+		auto &parameter = (*pair.first).second;
+		parameter.value.popup = initialValue;
+		mParams->addParam(name, options, &parameter.value.popup);
+	}
+}
+
+void AppAEdev::addParameter(const std::string &name, const std::vector<float> &initialValue)
+{
+	if (mParameters.count(name) == 0)
+	{
+		//arrays are not editable, the initial value is used
+		const auto &pair = mParameters.insert(std::make_pair(name, Parameter{ name, ParameterType::FloatArray }));
+		auto &parameter = (*pair.first).second;
+		parameter.value.array = initialValue;
+	}
+}
+
 ParameterValue AppAEdev::getParameter(const std::string &name, uint32_t) const
 {
 	assert(mParameters.count(name) > 0);
@@ -205,12 +248,91 @@ ParameterValue AppAEdev::getParameter(const std::string &name, uint32_t) const
 			return parameter.value.point3d;
 		case ParameterType::Color:
 			return parameter.value.color;
+		case ParameterType::Angle:
+			return parameter.value.angle;
+		case ParameterType::Integer:
+			return parameter.value.integer;
+		case ParameterType::Popup:
+			return parameter.value.popup;
+		case ParameterType::ColorA:
+			return parameter.value.colorA;
+		case ParameterType::FloatArray:
+			break;
 	}
 
 	assert(0);
 	return {};
 }
 
+std::vector<float> AppAEdev::getArrayParameter(const std::string &name, uint32_t) const
+{
+	assert(mParameters.count(name) > 0);
+
+	const auto it = mParameters.find(name);
+	const auto &parameter = it->second;
+
+	return parameter.value.array;
+}
+
+cinder::Surface AppAEdev::getLayerSurface(uint32_t frame)
+{
+	loadLayer();
+
+	if (!mLayerMovie.empty())
+	{
+		return mLayerMovie.getSurface(frame);
+	}
+	else if (!mLayerSequence.empty())
+	{
+		return mLayerSequence.getSurface(frame);
+	}
+
+	return cinder::Surface{};
+}
+
+cinder::gl::TextureRef AppAEdev::getLayerTexture(uint32_t frame)
+{
+	loadLayer();
+
+	if (!mLayerMovie.empty())
+	{
+		return mLayerMovie.getTexture(frame);
+	}
+	else if (!mLayerSequence.empty())
+	{
+		return mLayerSequence.getTexture(frame);
+	}
+
+	return nullptr;
+}
+
+void AppAEdev::loadLayer()
+{
+	if (mLayerPath == mSourcePath && mLayerTime == mSourceTime)
+	{
+		return;
+	}
+
+	mLayerPath = mSourcePath;
+	mLayerTime = mSourceTime;
+	mLayerMovie.reset();
+	mLayerSequence.reset();
+
+	if (mLayerPath.empty())
+	{
+		return;
+	}
+
+	if (MovieLoader::isMovie(mLayerPath))
+	{
+		mLayerMovie.load(mLayerPath, mLayerTime, mFps);
+	}
+	else
+	{
+		mLayerSequence.load(mLayerPath);
+	}
+}
+
 CameraAE::Parameter AppAEdev::getCameraParameter(uint32_t) const
 {
 	float fov = mCamera.getFov();
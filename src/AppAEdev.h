@@ -25,6 +25,8 @@
 #pragma once
 
 #include "IAppAE.h"
+#include "ImageSequenceLoader.h"
+#include "MovieLoader.h"
 #include "cinder/params/Params.h"
 #include <map>
 
@@ -45,6 +47,11 @@ private:
 			cinder::vec2 point;
 			cinder::vec3 point3d;
 			cinder::Color color;
+			float angle;
+			int32_t integer;
+			int32_t popup;
+			cinder::ColorA colorA;
+			std::vector<float> array;
 		};
 		std::string name;
 		ParameterType type;
@@ -75,13 +82,25 @@ protected:
 	std::string getSourcePath() const override { return mSourcePath; }
 	float getSourceTime() const override { return mSourceTime; }
 
+	using IAppAE::getLayerSurface;
+	// !Decodes the source of the layer instead, since there is no After Effects to share its pixels.
+	cinder::Surface getLayerSurface(uint32_t frame) override;
+	using IAppAE::getLayerTexture;
+	cinder::gl::TextureRef getLayerTexture(uint32_t frame) override;
+
 	using IAppAE::addParameter;
 	void addParameter(const std::string &name, ParameterType type, ParameterValue initialValue) override;
+	void addParameter(const std::string &name, const std::vector<std::string> &options, int32_t initialValue) override;
+	void addParameter(const std::string &name, const std::vector<float> &initialValue) override;
 
 	using IAppAE::getParameter;
 	// !Same as getParameter(const std::string &).
 	ParameterValue getParameter(const std::string &name, uint32_t /* frame */) const override;
 
+	using IAppAE::getArrayParameter;
+	// !Same as getArrayParameter(const std::string &).
+	std::vector<float> getArrayParameter(const std::string &name, uint32_t /* frame */) const override;
+
 	using IAppAE::getCameraParameter;
 	// !Same as getCameraParameter().
 	CameraAE::Parameter getCameraParameter(uint32_t /* frame */) const override;
@@ -89,6 +108,7 @@ protected:
 private:
 	void setupParams();
 	void updateCamera();
+	void loadLayer();
 
 	bool mPause = false;
 	uint32_t mCurrentFrame = 0;
@@ -100,6 +120,10 @@ private:
 	cinder::vec3 mUp;
 	cinder::params::InterfaceGlRef mParams;
 	std::map<std::string, Parameter> mParameters;
+	ImageSequenceLoader mLayerSequence;
+	MovieLoader mLayerMovie;
+	std::string mLayerPath;
+	float mLayerTime = 0.f;
 
 	//from AE
 	uint32_t mDuration = 900;
@@ -0,0 +1,171 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "CameraAE.h"
+#include "cinder/CinderMath.h"
+#include "cinder/Quaternion.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace atarabi {
+
+namespace {
+
+//the matrix elements the conversion reads, after flipping y and z as CameraAE::setParameter does
+struct Elements {
+	std::vector<float> m00, m01, m02, m11, m12, m21, m22;
+	std::vector<float> fov;
+
+	void resize(std::size_t size)
+	{
+		for (auto *values : { &m00, &m01, &m02, &m11, &m12, &m21, &m22, &fov })
+		{
+			values->resize(size);
+		}
+	}
+};
+
+void gather(const std::vector<CameraAE::Parameter> &parameters, std::size_t first, std::size_t last, Elements *elements, CameraAE::Transforms *transforms)
+{
+	for (std::size_t i = first; i < last; ++i)
+	{
+		const auto &m = parameters[i].cameraMatrix;
+		elements->m00[i] = m[0][0];
+		elements->m01[i] = m[0][1];
+		elements->m02[i] = m[0][2];
+		elements->m11[i] = -m[1][1];
+		elements->m12[i] = -m[1][2];
+		elements->m21[i] = -m[2][1];
+		elements->m22[i] = -m[2][2];
+		elements->fov[i] = parameters[i].fov;
+
+		//glm is column-major, the translation is the last column, which the flip does not touch
+		transforms->positionX[i] = m[3].x;
+		transforms->positionY[i] = m[3].y;
+		transforms->positionZ[i] = m[3].z;
+	}
+}
+
+//one pass over contiguous arrays, the gimbal lock case is selected per element
+void convert(const Elements &elements, float height, std::size_t first, std::size_t last, CameraAE::Transforms *transforms)
+{
+	const float pi = static_cast<float>(M_PI);
+	const float degrees = 57.295779513082321f; // ( x * 180 / PI )
+
+	const float *m00 = elements.m00.data();
+	const float *m01 = elements.m01.data();
+	const float *m02 = elements.m02.data();
+	const float *m11 = elements.m11.data();
+	const float *m12 = elements.m12.data();
+	const float *m21 = elements.m21.data();
+	const float *m22 = elements.m22.data();
+	const float *fov = elements.fov.data();
+	float *x = transforms->orientationX.data();
+	float *y = transforms->orientationY.data();
+	float *z = transforms->orientationZ.data();
+	float *zoom = transforms->zoom.data();
+
+	for (std::size_t i = first; i < last; ++i)
+	{
+		float orientationY = std::asin(m02[i]);
+		float cosY = std::cos(orientationY);
+		bool gimbalLock = cosY == 0.f;
+
+		float orientationX = gimbalLock ? std::atan2(m21[i], m11[i]) : std::atan2(-m12[i], m22[i]);
+		float orientationZ = std::asin(-m01[i] / (gimbalLock ? 1.f : cosY));
+		orientationZ = m00[i] < 0.f ? pi - orientationZ : orientationZ;
+
+		x[i] = orientationX * degrees;
+		y[i] = (gimbalLock ? 0.5f * pi : orientationY) * degrees;
+		z[i] = gimbalLock ? 0.f : orientationZ * degrees;
+	}
+
+	for (std::size_t i = first; i < last; ++i)
+	{
+		zoom[i] = height / (2.f * std::tan(0.5f * cinder::toRadians(fov[i])));
+	}
+}
+
+} //anonymous namespace
+
+void CameraAE::Transforms::resize(std::size_t size)
+{
+	for (auto *values : { &positionX, &positionY, &positionZ, &orientationX, &orientationY, &orientationZ, &zoom })
+	{
+		values->resize(size);
+	}
+}
+
+void CameraAE::toTransforms(const std::vector<Parameter> &parameters, float height, Transforms *transforms, int numThreads)
+{
+	static const std::size_t MIN_CHUNK_SIZE = 1024;
+
+	std::size_t size = parameters.size();
+	transforms->resize(size);
+
+	Elements elements;
+	elements.resize(size);
+
+	auto process = [&](std::size_t first, std::size_t last) -> void {
+		gather(parameters, first, last, &elements, transforms);
+		convert(elements, height, first, last, transforms);
+	};
+
+	std::size_t numChunks = std::min(static_cast<std::size_t>(std::max(1, numThreads)), (size + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE);
+	if (numChunks <= 1)
+	{
+		process(0, size);
+		return;
+	}
+
+	std::size_t chunkSize = (size + numChunks - 1) / numChunks;
+	std::vector<std::thread> threads;
+	for (std::size_t first = chunkSize; first < size; first += chunkSize)
+	{
+		threads.emplace_back(process, first, std::min(size, first + chunkSize));
+	}
+
+	process(0, std::min(size, chunkSize));
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+CameraAE::Parameter CameraAE::interpolate(const Parameter &from, const Parameter &to, float t)
+{
+	Parameter parameter;
+	parameter.fov = cinder::lerp(from.fov, to.fov, t);
+
+	//the rotation is slerped, lerping the matrix would shear it
+	cinder::quat rotation = glm::slerp(glm::quat_cast(from.cameraMatrix), glm::quat_cast(to.cameraMatrix), t);
+	parameter.cameraMatrix = glm::mat4_cast(rotation);
+	parameter.cameraMatrix[3] = cinder::lerp(from.cameraMatrix[3], to.cameraMatrix[3], t);
+
+	return parameter;
+}
+
+}
\ No newline at end of file
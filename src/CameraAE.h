@@ -26,6 +26,7 @@
 
 #include "cinder/Camera.h"
 #include "cinder/Matrix44.h"
+#include <vector>
 
 namespace atarabi {
 
@@ -36,6 +37,22 @@ public:
 		cinder::mat4 cameraMatrix;
 	};
 
+	//! After Effects' camera properties of many frames, stored per component.
+	struct Transforms {
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> orientationX, orientationY, orientationZ;
+		std::vector<float> zoom;
+
+		void resize(std::size_t size);
+		std::size_t size() const { return zoom.size(); }
+	};
+
+	//! Converts camera parameters to After Effects' position, orientation(degrees) and zoom for a layer of the given height, splitting the work across numThreads threads.
+	static void toTransforms(const std::vector<Parameter> &parameters, float height, Transforms *transforms, int numThreads = 1);
+
+	//! Interpolates between the parameters of two frames, e.g. for the sub-frames of motion blur.
+	static Parameter interpolate(const Parameter &from, const Parameter &to, float t);
+
 	void setParameter(const Parameter &parameter)
 	{
 		setFov(parameter.fov);
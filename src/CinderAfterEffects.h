@@ -27,3 +27,14 @@
 #include "AppAE.h"
 #include "AppAEdev.h"
 #include "ImageSequenceLoader.h"
+#include "TextureStreamer.h"
+#include "FrameCache.h"
+#include "MovieLoader.h"
+#include "FrameChannel.h"
+#include "ParticleSystem.h"
+#include "ParticleRenderer.h"
+#include "CounterRand.h"
+#include "ComputeState.h"
+#include "SpatialGrid.h"
+#include "TimelineAE.h"
+#include "RenderTarget.h"
@@ -0,0 +1,180 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "ComputeState.h"
+
+#include <fstream>
+#include <cstring>
+
+namespace atarabi {
+
+namespace {
+
+const char MAGIC[8] = { 'C', 'I', 'A', 'E', 'S', 'N', 'A', 'P' };
+
+} //anonymous namespace
+
+ComputeState::ComputeState(GLsizeiptr bytes, const void *initialData) : mSize{ bytes }
+{
+	for (auto &buffer : mBuffers)
+	{
+		buffer = cinder::gl::Ssbo::create(bytes, initialData, GL_DYNAMIC_COPY);
+	}
+}
+
+void ComputeState::bind(GLuint readBinding, GLuint writeBinding)
+{
+	getCurrent()->bindBase(readBinding);
+	getNext()->bindBase(writeBinding);
+}
+
+bool ComputeState::upload(const void *data, GLsizeiptr bytes)
+{
+	if (bytes != mSize)
+	{
+		return false;
+	}
+
+	getCurrent()->bufferSubData(0, bytes, data);
+	return true;
+}
+
+void ComputeState::requestSnapshot(uint32_t frame)
+{
+	//one snapshot at a time
+	if (mFence)
+	{
+		return;
+	}
+
+	if (!mStaging)
+	{
+		mStaging = cinder::gl::BufferObj::create(GL_COPY_WRITE_BUFFER, mSize, nullptr, GL_STREAM_READ);
+	}
+
+	//the steps dispatched so far must have written the buffer
+	cinder::gl::memoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	cinder::gl::ScopedBuffer scopedRead{ GL_COPY_READ_BUFFER, getCurrent()->getId() };
+	cinder::gl::ScopedBuffer scopedWrite{ GL_COPY_WRITE_BUFFER, mStaging->getId() };
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, mSize);
+
+	mFence = cinder::gl::Sync::create();
+	mSnapshotFrame = frame;
+}
+
+bool ComputeState::pollSnapshot(Snapshot *snapshot, bool wait)
+{
+	if (!mFence)
+	{
+		return false;
+	}
+
+	GLenum result = mFence->clientWaitSync(GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GL_TIMEOUT_IGNORED : 0);
+	if (result == GL_WAIT_FAILED)
+	{
+		//the fence would fail again on every poll, so that no snapshot could be requested anymore
+		mFence.reset();
+		return false;
+	}
+	if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+	{
+		return false;
+	}
+	mFence.reset();
+
+	cinder::gl::ScopedBuffer scopedStaging{ GL_COPY_WRITE_BUFFER, mStaging->getId() };
+	auto data = static_cast<const uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, mSize, GL_MAP_READ_BIT));
+	if (!data)
+	{
+		return false;
+	}
+
+	snapshot->frame = mSnapshotFrame;
+	snapshot->data.assign(data, data + mSize);
+	glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+
+	return true;
+}
+
+bool ComputeState::saveSnapshot(const Snapshot &snapshot, const cinder::fs::path &path)
+{
+	std::ofstream stream{ path.string().c_str(), std::ios::binary | std::ios::trunc };
+	if (!stream)
+	{
+		return false;
+	}
+
+	uint64_t bytes = snapshot.data.size();
+	stream.write(MAGIC, sizeof(MAGIC));
+	stream.write(reinterpret_cast<const char*>(&snapshot.frame), sizeof(snapshot.frame));
+	stream.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+	stream.write(reinterpret_cast<const char*>(snapshot.data.data()), bytes);
+
+	return static_cast<bool>(stream);
+}
+
+bool ComputeState::loadSnapshot(const cinder::fs::path &path, Snapshot *snapshot, uint64_t expectedBytes)
+{
+	std::ifstream stream{ path.string().c_str(), std::ios::binary };
+	if (!stream)
+	{
+		return false;
+	}
+
+	char magic[sizeof(MAGIC)];
+	uint32_t frame;
+	uint64_t bytes;
+	stream.read(magic, sizeof(magic));
+	stream.read(reinterpret_cast<char*>(&frame), sizeof(frame));
+	stream.read(reinterpret_cast<char*>(&bytes), sizeof(bytes));
+	if (!stream || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+	{
+		return false;
+	}
+
+	//the size is checked before allocating, a damaged header must not ask for gigabytes
+	std::streamoff header = stream.tellg();
+	stream.seekg(0, std::ios::end);
+	std::streamoff fileSize = stream.tellg();
+	stream.seekg(header);
+	if (!stream || static_cast<uint64_t>(fileSize - header) != bytes || (expectedBytes != 0 && bytes != expectedBytes))
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> data(static_cast<std::size_t>(bytes));
+	stream.read(reinterpret_cast<char*>(data.data()), bytes);
+	if (!stream)
+	{
+		return false;
+	}
+
+	snapshot->frame = frame;
+	snapshot->data.swap(data);
+
+	return true;
+}
+
+}
\ No newline at end of file
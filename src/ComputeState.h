@@ -0,0 +1,90 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Ssbo.h"
+#include "cinder/gl/Sync.h"
+#include "cinder/Filesystem.h"
+
+#include <vector>
+#include <array>
+
+namespace atarabi {
+
+/*
+* The state of a compute shader simulation in a pair of shader storage buffers, read from one and written to the other each step.
+*/
+class ComputeState {
+public:
+	//! A copy of the state on the CPU, e.g. to resume a render from a frame or to restart without regenerating it.
+	struct Snapshot {
+		uint32_t frame = 0;
+		std::vector<uint8_t> data;
+
+		bool empty() const { return data.empty(); }
+	};
+
+	//! Allocates both buffers with initialData(it can be nullptr), must be called on the GL thread.
+	ComputeState(GLsizeiptr bytes, const void *initialData = nullptr);
+
+	GLsizeiptr getSize() const { return mSize; }
+
+	//! Returns the buffer holding the current state.
+	const cinder::gl::SsboRef &getCurrent() const { return mBuffers[mCurrent]; }
+	//! Returns the buffer which the next step writes.
+	const cinder::gl::SsboRef &getNext() const { return mBuffers[1 - mCurrent]; }
+
+	//! Binds the current state to readBinding and the next one to writeBinding before dispatching a step.
+	void bind(GLuint readBinding, GLuint writeBinding);
+	//! Makes the written buffer current after the step has been dispatched.
+	void swap() { mCurrent = 1 - mCurrent; }
+
+	//! Replaces the current state, returns false and leaves it as it is when bytes is not getSize().
+	bool upload(const void *data, GLsizeiptr bytes);
+	bool upload(const Snapshot &snapshot) { return upload(snapshot.data.data(), static_cast<GLsizeiptr>(snapshot.data.size())); }
+
+	//! Starts copying the current state into a staging buffer without waiting for the GPU.
+	void requestSnapshot(uint32_t frame);
+	//! Returns whether a requested snapshot is waiting to be collected.
+	bool isSnapshotPending() const { return static_cast<bool>(mFence); }
+	//! Moves the requested snapshot into snapshot once the copy has finished, waiting for it when wait is true(a failed wait drops the request).
+	bool pollSnapshot(Snapshot *snapshot, bool wait = false);
+
+	static bool saveSnapshot(const Snapshot &snapshot, const cinder::fs::path &path);
+	//! Fails when the file is damaged or, unless expectedBytes is 0, holds a state of another size.
+	static bool loadSnapshot(const cinder::fs::path &path, Snapshot *snapshot, uint64_t expectedBytes = 0);
+
+private:
+	GLsizeiptr mSize;
+	std::array<cinder::gl::SsboRef, 2> mBuffers;
+	int mCurrent = 0;
+
+	cinder::gl::BufferObjRef mStaging;
+	cinder::gl::SyncRef mFence;
+	uint32_t mSnapshotFrame = 0;
+};
+
+}
\ No newline at end of file
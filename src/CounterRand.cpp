@@ -0,0 +1,122 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "CounterRand.h"
+
+#include <cmath>
+
+namespace atarabi {
+
+namespace {
+
+const uint32_t PHILOX_M0 = 0xD2511F53;
+const uint32_t PHILOX_M1 = 0xCD9E8D57;
+const uint32_t PHILOX_W0 = 0x9E3779B9;
+const uint32_t PHILOX_W1 = 0xBB67AE85;
+const int PHILOX_ROUNDS = 10;
+
+const float TWO_PI = 6.28318530717958647692f;
+
+inline void mulhilo(uint32_t a, uint32_t b, uint32_t *hi, uint32_t *lo)
+{
+	uint64_t product = static_cast<uint64_t>(a) * b;
+	*hi = static_cast<uint32_t>(product >> 32);
+	*lo = static_cast<uint32_t>(product);
+}
+
+} //anonymous namespace
+
+CounterRand::Block CounterRand::philox(uint64_t seed, uint32_t frame, uint32_t stream, uint64_t index)
+{
+	Block counter = { static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), frame, stream };
+	uint32_t key0 = static_cast<uint32_t>(seed);
+	uint32_t key1 = static_cast<uint32_t>(seed >> 32);
+
+	for (int round = 0; round < PHILOX_ROUNDS; ++round)
+	{
+		uint32_t hi0, lo0, hi1, lo1;
+		mulhilo(PHILOX_M0, counter[0], &hi0, &lo0);
+		mulhilo(PHILOX_M1, counter[2], &hi1, &lo1);
+		counter = { hi1 ^ counter[1] ^ key0, lo1, hi0 ^ counter[3] ^ key1, lo0 };
+		key0 += PHILOX_W0;
+		key1 += PHILOX_W1;
+	}
+
+	return counter;
+}
+
+void CounterRand::fillFloats(uint64_t seed, uint32_t frame, uint32_t stream, uint64_t first, std::size_t count, float *values)
+{
+	uint64_t index = first;
+	std::size_t i = 0;
+
+	//the head up to a block boundary
+	for (; i < count && (index & 3) != 0; ++i, ++index)
+	{
+		values[i] = toFloat(philox(seed, frame, stream, index >> 2)[index & 3]);
+	}
+
+	//whole blocks, independent of each other
+	for (; i + 4 <= count; i += 4, index += 4)
+	{
+		Block block = philox(seed, frame, stream, index >> 2);
+		for (int j = 0; j < 4; ++j)
+		{
+			values[i + j] = toFloat(block[j]);
+		}
+	}
+
+	for (; i < count; ++i, ++index)
+	{
+		values[i] = toFloat(philox(seed, frame, stream, index >> 2)[index & 3]);
+	}
+}
+
+uint32_t CounterRand::nextUint()
+{
+	uint64_t blockIndex = mCounter >> 2;
+	if (blockIndex != mBlockIndex)
+	{
+		mBlock = philox(mSeed, mFrame, mStream, blockIndex);
+		mBlockIndex = blockIndex;
+	}
+
+	return mBlock[mCounter++ & 3];
+}
+
+cinder::vec2 CounterRand::nextVec2()
+{
+	float theta = nextFloat(TWO_PI);
+	return cinder::vec2{ std::cos(theta), std::sin(theta) };
+}
+
+cinder::vec3 CounterRand::nextVec3()
+{
+	float phi = nextFloat(TWO_PI);
+	float z = nextFloatSigned();
+	float r = std::sqrt(1.f - z * z);
+	return cinder::vec3{ r * std::cos(phi), r * std::sin(phi), z };
+}
+
+}
\ No newline at end of file
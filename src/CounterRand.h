@@ -0,0 +1,80 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "cinder/Vector.h"
+
+#include <cstdint>
+#include <array>
+
+namespace atarabi {
+
+/*
+* Random numbers computed from (seed, frame, stream, index) with Philox4x32-10, so that any frame can be reproduced without the previous ones.
+* The interface follows cinder::Rand.
+*/
+class CounterRand {
+public:
+	using Block = std::array<uint32_t, 4>;
+
+	CounterRand(uint64_t seed = 0, uint32_t frame = 0, uint32_t stream = 0) : mSeed{ seed }, mFrame{ frame }, mStream{ stream } {}
+
+	//! Returns the four numbers of the block at index, the same for the same arguments on any thread.
+	static Block philox(uint64_t seed, uint32_t frame, uint32_t stream, uint64_t index);
+	//! Writes count floats in [0, 1), the same as calling nextFloat() count times after skipping first numbers.
+	static void fillFloats(uint64_t seed, uint32_t frame, uint32_t stream, uint64_t first, std::size_t count, float *values);
+
+	//! Moves to the index-th number, e.g. to give each particle its own numbers.
+	void seek(uint64_t index) { mCounter = index; }
+	uint64_t tell() const { return mCounter; }
+
+	uint32_t nextUint();
+	uint32_t nextUint(uint32_t max) { return max ? static_cast<uint32_t>((static_cast<uint64_t>(nextUint()) * max) >> 32) : 0; }
+	int32_t nextInt(int32_t min, int32_t max) { return min + static_cast<int32_t>(nextUint(static_cast<uint32_t>(max - min))); }
+	bool nextBool() { return (nextUint() & 1) != 0; }
+	//! Returns a float in [0, 1).
+	float nextFloat() { return toFloat(nextUint()); }
+	float nextFloat(float max) { return nextFloat() * max; }
+	float nextFloat(float min, float max) { return min + nextFloat() * (max - min); }
+	//! Returns a float in [-1, 1).
+	float nextFloatSigned() { return nextFloat() * 2.f - 1.f; }
+	//! Returns a unit vector.
+	cinder::vec2 nextVec2();
+	//! Returns a unit vector.
+	cinder::vec3 nextVec3();
+
+private:
+	static float toFloat(uint32_t value) { return (value >> 8) * (1.f / 16777216.f); }
+
+	uint64_t mSeed;
+	uint32_t mFrame;
+	uint32_t mStream;
+	uint64_t mCounter = 0;
+	//the block holding mCounter, computed once per four numbers
+	uint64_t mBlockIndex = UINT64_MAX;
+	Block mBlock;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,284 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "FrameCache.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Thread.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <future>
+
+namespace atarabi {
+
+namespace {
+
+const char MAGIC[8] = { 'C', 'I', 'A', 'E', 'F', 'R', 'M', 'S' };
+
+uint64_t fnv1a(uint64_t hash, const void *data, std::size_t size)
+{
+	auto bytes = static_cast<const uint8_t*>(data);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+//the bytes per pixel of the 8 bit channel orders a Surface can have, 0 for anything else
+int32_t getPixelBytes(int32_t channelOrder)
+{
+	switch (channelOrder)
+	{
+	case cinder::SurfaceChannelOrder::RGBA:
+	case cinder::SurfaceChannelOrder::BGRA:
+	case cinder::SurfaceChannelOrder::ARGB:
+	case cinder::SurfaceChannelOrder::ABGR:
+	case cinder::SurfaceChannelOrder::RGBX:
+	case cinder::SurfaceChannelOrder::BGRX:
+	case cinder::SurfaceChannelOrder::XRGB:
+	case cinder::SurfaceChannelOrder::XBGR:
+		return 4;
+	case cinder::SurfaceChannelOrder::RGB:
+	case cinder::SurfaceChannelOrder::BGR:
+		return 3;
+	default:
+		return 0;
+	}
+}
+
+void removeFile(const cinder::fs::path &path)
+{
+	try
+	{
+		cinder::fs::remove(path);
+	}
+	catch (...)
+	{
+		//pass
+	}
+}
+
+} //anonymous namespace
+
+const int FrameCache::VERSION;
+
+uint64_t FrameCache::getSignature(const std::vector<cinder::fs::path> &files)
+{
+	uint64_t hash = 14695981039346656037ull;
+	hash = fnv1a(hash, &VERSION, sizeof(VERSION));
+
+	for (const auto &file : files)
+	{
+		std::string name = file.filename().string();
+		uint64_t size = static_cast<uint64_t>(cinder::fs::file_size(file));
+		int64_t modifiedTime = static_cast<int64_t>(cinder::fs::last_write_time(file));
+		hash = fnv1a(hash, name.data(), name.size());
+		hash = fnv1a(hash, &size, sizeof(size));
+		hash = fnv1a(hash, &modifiedTime, sizeof(modifiedTime));
+	}
+
+	return hash;
+}
+
+std::shared_ptr<FrameCache> FrameCache::open(const cinder::fs::path &cachePath, uint64_t signature, std::size_t numFrames)
+{
+	if (!cinder::fs::exists(cachePath))
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<FrameCache> cache{ new FrameCache{} };
+	if (!cache->mFile.open(cachePath))
+	{
+		return nullptr;
+	}
+
+	std::size_t size = cache->mFile.getSize();
+	if (size < sizeof(Header))
+	{
+		return nullptr;
+	}
+
+	Header header;
+	std::memcpy(&header, cache->mFile.getData(), sizeof(Header));
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.signature != signature || header.numFrames != numFrames)
+	{
+		return nullptr;
+	}
+
+	cache->mNumFrames = header.numFrames;
+
+	//reject truncated files, e.g. when writing was interrupted
+	uint64_t indexEnd = sizeof(Header) + static_cast<uint64_t>(numFrames) * sizeof(Entry);
+	if (size < indexEnd)
+	{
+		return nullptr;
+	}
+
+	//the pixels of a damaged entry could point outside the mapping, such a frame is decoded again instead
+	cache->mValid.resize(numFrames);
+	for (std::size_t i = 0; i < numFrames; ++i)
+	{
+		const auto &entry = cache->getEntry(static_cast<int32_t>(i));
+		int32_t pixelBytes = getPixelBytes(entry.channelOrder);
+		bool valid = pixelBytes > 0 && entry.width > 0 && entry.height > 0
+			&& static_cast<int64_t>(entry.rowBytes) >= static_cast<int64_t>(entry.width) * pixelBytes
+			&& entry.bytes == static_cast<uint64_t>(entry.rowBytes) * static_cast<uint64_t>(entry.height)
+			&& entry.offset >= indexEnd && entry.offset <= size && entry.bytes <= size - entry.offset;
+		cache->mValid[i] = valid;
+	}
+
+	return cache;
+}
+
+std::shared_ptr<FrameCache> FrameCache::create(const cinder::fs::path &cachePath, uint64_t signature, const std::vector<cinder::fs::path> &files, int numThreads)
+{
+	if (numThreads <= 0)
+	{
+		numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	cinder::fs::path temporaryPath = cachePath.string() + ".tmp";
+
+	if (!write(temporaryPath, signature, files, numThreads))
+	{
+		//do not leave a partial file behind
+		removeFile(temporaryPath);
+		return nullptr;
+	}
+
+	//only a complete file ever gets the final name
+	try
+	{
+		cinder::fs::remove(cachePath);
+		cinder::fs::rename(temporaryPath, cachePath);
+	}
+	catch (...)
+	{
+		removeFile(temporaryPath);
+		return nullptr;
+	}
+
+	return open(cachePath, signature, files.size());
+}
+
+bool FrameCache::write(const cinder::fs::path &path, uint64_t signature, const std::vector<cinder::fs::path> &files, int numThreads)
+{
+	std::ofstream stream{ path.string().c_str(), std::ios::binary | std::ios::trunc };
+	if (!stream)
+	{
+		return false;
+	}
+
+	Header header;
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.numFrames = static_cast<uint32_t>(files.size());
+	header.signature = signature;
+
+	std::vector<Entry> entries(files.size());
+	uint64_t offset = sizeof(Header) + entries.size() * sizeof(Entry);
+
+	//reserve the index, it is rewritten once the sizes are known
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	stream.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+
+	auto decode = [](const cinder::fs::path &file) -> cinder::Surface {
+		cinder::ThreadSetup threadSetup;
+		return cinder::Surface{ cinder::loadImage(file) };
+	};
+
+	static const char padding[ALIGNMENT] = {};
+
+	for (std::size_t first = 0; first < files.size(); first += numThreads)
+	{
+		std::size_t last = std::min(files.size(), first + numThreads);
+
+		std::vector<std::future<cinder::Surface>> surfaces;
+		for (std::size_t i = first; i < last; ++i)
+		{
+			surfaces.push_back(std::async(std::launch::async, decode, files[i]));
+		}
+
+		for (std::size_t i = first; i < last; ++i)
+		{
+			cinder::Surface surface;
+			try
+			{
+				surface = surfaces[i - first].get();
+			}
+			catch (...)
+			{
+				return false;
+			}
+
+			uint64_t aligned = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+			stream.write(padding, aligned - offset);
+			offset = aligned;
+
+			auto &entry = entries[i];
+			entry.offset = offset;
+			entry.width = surface.getWidth();
+			entry.height = surface.getHeight();
+			entry.rowBytes = static_cast<int32_t>(surface.getRowBytes());
+			entry.channelOrder = surface.getChannelOrder().getCode();
+			entry.bytes = static_cast<uint64_t>(entry.rowBytes) * entry.height;
+
+			stream.write(reinterpret_cast<const char*>(surface.getData()), entry.bytes);
+			offset += entry.bytes;
+		}
+	}
+
+	stream.seekp(sizeof(Header));
+	stream.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+
+	if (!stream)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+cinder::Surface FrameCache::getSurface(int32_t index) const
+{
+	const auto &entry = getEntry(index);
+	auto data = const_cast<uint8_t*>(mFile.getData() + entry.offset);
+
+	//copy out of the mapping, the surface may outlive the cache(e.g. a loader reset while a frame is still held)
+	return cinder::Surface{ data, entry.width, entry.height, entry.rowBytes, cinder::SurfaceChannelOrder{ entry.channelOrder } }.clone();
+}
+
+const FrameCache::Entry &FrameCache::getEntry(int32_t index) const
+{
+	assert(index >= 0 && static_cast<std::size_t>(index) < mNumFrames);
+
+	return reinterpret_cast<const Entry*>(mFile.getData() + sizeof(Header))[index];
+}
+
+}
\ No newline at end of file
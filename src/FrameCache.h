@@ -0,0 +1,87 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "MappedFile.h"
+#include "cinder/Surface.h"
+#include "cinder/Filesystem.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace atarabi {
+
+/*
+* A single file of raw decoded frames which is memory-mapped instead of decoding each image again.
+*/
+class FrameCache {
+public:
+	static const int VERSION = 1;
+
+	//! Returns a hash of the names, sizes and modification times of the files, which invalidates the cache when any of them changes.
+	static uint64_t getSignature(const std::vector<cinder::fs::path> &files);
+
+	//! Maps an existing cache, returns nullptr when it is missing or was made from other files, frames which do not fit in the file are dropped.
+	static std::shared_ptr<FrameCache> open(const cinder::fs::path &cachePath, uint64_t signature, std::size_t numFrames);
+	//! Decodes the files on numThreads threads(0 means the number of cores), writes them to cachePath and maps it.
+	static std::shared_ptr<FrameCache> create(const cinder::fs::path &cachePath, uint64_t signature, const std::vector<cinder::fs::path> &files, int numThreads = 0);
+
+	int32_t getNumFrames() const { return static_cast<int32_t>(mNumFrames); }
+	//! Returns whether the frame was kept when opening, otherwise it has to be decoded from its file.
+	bool hasFrame(int32_t index) const { return mValid[index]; }
+	//! Returns a copy of the frame(hasFrame() must be true), which owns its pixels and stays valid after this cache is released.
+	cinder::Surface getSurface(int32_t index) const;
+
+private:
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t numFrames;
+		uint64_t signature;
+	};
+
+	struct Entry {
+		uint64_t offset;
+		uint64_t bytes;
+		int32_t width;
+		int32_t height;
+		int32_t rowBytes;
+		int32_t channelOrder;
+	};
+
+	static const uint64_t ALIGNMENT = 64;
+
+	//! Writes the header, index and frames to path, returns false on any error.
+	static bool write(const cinder::fs::path &path, uint64_t signature, const std::vector<cinder::fs::path> &files, int numThreads);
+
+	const Entry &getEntry(int32_t index) const;
+
+	MappedFile mFile;
+	std::size_t mNumFrames = 0;
+	std::vector<bool> mValid;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "FrameChannel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <new>
+
+namespace atarabi {
+
+namespace {
+
+const char MAGIC[8] = { 'C', 'I', 'A', 'E', 'F', 'R', 'C', 'H' };
+
+} //anonymous namespace
+
+const int FrameChannel::VERSION;
+const uint32_t FrameChannel::DEFAULT_NUM_SLOTS;
+const double FrameChannel::DEFAULT_WRITE_TIMEOUT = 0.1;
+
+FrameChannel::~FrameChannel()
+{
+	if (!mMemory.isOpen() || std::memcmp(getHeader()->magic, MAGIC, sizeof(MAGIC)) != 0)
+	{
+		return;
+	}
+
+	Header *header = getHeader();
+	if (mWriter)
+	{
+		header->closed.store(1, std::memory_order_release);
+	}
+	else if (!isClosed())
+	{
+		header->numReaders.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+std::shared_ptr<FrameChannel> FrameChannel::create(const std::string &name, int32_t width, int32_t height, uint32_t numSlots)
+{
+	uint64_t slotBytes = getOffset(sizeof(Slot)) + getOffset(static_cast<uint64_t>(width) * height * 4);
+	uint64_t size = getOffset(sizeof(Header)) + slotBytes * numSlots;
+
+	std::shared_ptr<FrameChannel> channel{ new FrameChannel{} };
+	if (!channel->mMemory.create(name, static_cast<std::size_t>(size)))
+	{
+		return nullptr;
+	}
+
+	//readers check the magic last, so it is written after everything else
+	Header *header = new (channel->mMemory.getData()) Header{};
+	header->version = VERSION;
+	header->numSlots = numSlots;
+	header->width = width;
+	header->height = height;
+	header->slotBytes = slotBytes;
+	//tells readers of a previous channel with the same name that it was recreated
+	header->id = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+	header->writeCount.store(0);
+	header->readCount.store(0);
+	header->droppedCount.store(0);
+	header->numReaders.store(0);
+	header->closed.store(0);
+
+	for (uint32_t i = 0; i < numSlots; ++i)
+	{
+		Slot *slot = new (channel->getSlot(i)) Slot{};
+		slot->sequence.store(0);
+		slot->frame.store(UINT32_MAX);
+		slot->count.store(0);
+	}
+
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+
+	channel->mWriter = true;
+	channel->mId = header->id;
+
+	return channel;
+}
+
+std::shared_ptr<FrameChannel> FrameChannel::open(const std::string &name)
+{
+	std::shared_ptr<FrameChannel> channel{ new FrameChannel{} };
+	if (!channel->mMemory.open(name))
+	{
+		return nullptr;
+	}
+
+	std::size_t size = channel->mMemory.getSize();
+	if (size < sizeof(Header))
+	{
+		return nullptr;
+	}
+
+	const Header *header = channel->getHeader();
+	if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION)
+	{
+		return nullptr;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	if (getOffset(sizeof(Header)) + header->slotBytes * header->numSlots > size)
+	{
+		return nullptr;
+	}
+
+	channel->mId = header->id;
+	channel->getHeader()->numReaders.fetch_add(1, std::memory_order_relaxed);
+
+	return channel;
+}
+
+bool FrameChannel::write(uint32_t frame, const cinder::Surface &surface, double timeout)
+{
+	Header *header = getHeader();
+	if (surface.getWidth() != header->width || surface.getHeight() != header->height)
+	{
+		return false;
+	}
+
+	uint64_t writeCount = header->writeCount.load(std::memory_order_relaxed);
+	auto isFull = [header, writeCount]() -> bool {
+		return header->numReaders.load(std::memory_order_relaxed) > 0 && writeCount - header->readCount.load(std::memory_order_acquire) >= header->numSlots;
+	};
+
+	bool dropped = false;
+	if (isFull())
+	{
+		//back off while the reader catches up, unless it already failed to and has not read anything since
+		if (header->readCount.load(std::memory_order_relaxed) != mStalledReadCount)
+		{
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+			int interval = 1;
+			while (isFull() && std::chrono::steady_clock::now() < deadline)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+				interval = std::min(interval * 2, 8);
+			}
+		}
+
+		if (isFull())
+		{
+			mStalledReadCount = header->readCount.load(std::memory_order_relaxed);
+			header->droppedCount.fetch_add(1, std::memory_order_relaxed);
+			dropped = true;
+		}
+	}
+
+	uint32_t index = static_cast<uint32_t>(writeCount % header->numSlots);
+	Slot *slot = getSlot(index);
+	uint8_t *pixels = getPixels(index);
+
+	uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+	slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	cinder::Surface target{ pixels, header->width, header->height, header->width * 4, cinder::SurfaceChannelOrder::RGBA };
+	if (surface.getChannelOrder().getCode() == cinder::SurfaceChannelOrder::RGBA && surface.getRowBytes() == target.getRowBytes())
+	{
+		std::memcpy(pixels, surface.getData(), static_cast<std::size_t>(target.getRowBytes()) * header->height);
+	}
+	else
+	{
+		target.copyFrom(surface, surface.getBounds());
+	}
+
+	slot->frame.store(frame, std::memory_order_relaxed);
+	slot->count.store(writeCount + 1, std::memory_order_relaxed);
+	slot->sequence.store(sequence + 2, std::memory_order_release);
+	header->writeCount.fetch_add(1, std::memory_order_release);
+
+	return !dropped;
+}
+
+bool FrameChannel::read(uint32_t frame, cinder::Surface *surface, double timeout) const
+{
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+
+	while (!tryRead(frame, surface))
+	{
+		if (std::chrono::steady_clock::now() >= deadline)
+		{
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return true;
+}
+
+bool FrameChannel::isClosed() const
+{
+	const Header *header = getHeader();
+	return header->closed.load(std::memory_order_acquire) != 0 || header->id != mId;
+}
+
+int64_t FrameChannel::getLatestFrame() const
+{
+	uint64_t writeCount = getWriteCount();
+	if (writeCount == 0)
+	{
+		return -1;
+	}
+
+	const Slot *slot = getSlot(static_cast<uint32_t>((writeCount - 1) % getNumSlots()));
+	return slot->frame.load(std::memory_order_relaxed);
+}
+
+FrameChannel::Slot *FrameChannel::getSlot(uint32_t index) const
+{
+	const Header *header = getHeader();
+	return reinterpret_cast<Slot*>(mMemory.getData() + getOffset(sizeof(Header)) + header->slotBytes * index);
+}
+
+bool FrameChannel::tryRead(uint32_t frame, cinder::Surface *surface) const
+{
+	const Header *header = getHeader();
+	std::size_t bytes = static_cast<std::size_t>(header->width) * header->height * 4;
+
+	for (uint32_t i = 0; i < header->numSlots; ++i)
+	{
+		const Slot *slot = getSlot(i);
+
+		uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+		if ((sequence & 1) || slot->frame.load(std::memory_order_relaxed) != frame)
+		{
+			continue;
+		}
+
+		if (!surface->getData() || surface->getWidth() != header->width || surface->getHeight() != header->height || surface->getRowBytes() != header->width * 4)
+		{
+			*surface = cinder::Surface{ header->width, header->height, true, cinder::SurfaceChannelOrder::RGBA };
+		}
+		std::memcpy(surface->getData(), getPixels(i), bytes);
+
+		//the writer reused the slot while copying
+		uint64_t count = slot->count.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot->sequence.load(std::memory_order_relaxed) == sequence)
+		{
+			//frees this slot and the older ones for the writer
+			auto &readCount = getHeader()->readCount;
+			uint64_t current = readCount.load(std::memory_order_relaxed);
+			while (current < count && !readCount.compare_exchange_weak(current, count, std::memory_order_release, std::memory_order_relaxed))
+			{
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "SharedMemory.h"
+#include "cinder/Surface.h"
+
+#include <string>
+#include <memory>
+#include <atomic>
+
+namespace atarabi {
+
+/*
+* A ring of raw RGBA frames in shared memory, written by one process and read by another.
+*/
+class FrameChannel {
+public:
+	static const int VERSION = 2;
+	static const uint32_t DEFAULT_NUM_SLOTS = 4;
+	//! Seconds the writer waits for a reader to free a slot before it overwrites the oldest unread frame.
+	static const double DEFAULT_WRITE_TIMEOUT;
+
+	~FrameChannel();
+
+	//! Creates the channel as the writer.
+	static std::shared_ptr<FrameChannel> create(const std::string &name, int32_t width, int32_t height, uint32_t numSlots = DEFAULT_NUM_SLOTS);
+	//! Opens the channel created by the writer, returns nullptr when it does not exist yet.
+	static std::shared_ptr<FrameChannel> open(const std::string &name);
+
+	int32_t getWidth() const { return getHeader()->width; }
+	int32_t getHeight() const { return getHeader()->height; }
+	uint32_t getNumSlots() const { return getHeader()->numSlots; }
+
+	//! Copies the surface into the oldest slot, converting it to RGBA when needed.
+	//! While a reader is attached and every slot holds a frame it has not read, waits up to timeout seconds, then overwrites the oldest one and returns false.
+	bool write(uint32_t frame, const cinder::Surface &surface, double timeout = DEFAULT_WRITE_TIMEOUT);
+	//! Copies the frame into surface, waiting up to timeout seconds for the writer to publish it, which also frees the slots up to it for the writer.
+	bool read(uint32_t frame, cinder::Surface *surface, double timeout = 0.0) const;
+	//! Returns the number of frames written so far, which tells a consumer whether anything new arrived.
+	uint64_t getWriteCount() const { return getHeader()->writeCount.load(std::memory_order_acquire); }
+	//! Returns the most recently written frame, or -1 when nothing has been written.
+	int64_t getLatestFrame() const;
+	//! Returns the number of frames overwritten before a reader read them.
+	uint64_t getDroppedCount() const { return getHeader()->droppedCount.load(std::memory_order_relaxed); }
+	//! Returns whether the writer closed or recreated the channel, a reader must open it again.
+	bool isClosed() const;
+
+private:
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t numSlots;
+		int32_t width;
+		int32_t height;
+		uint64_t slotBytes;
+		uint64_t id;
+		std::atomic<uint64_t> writeCount;
+		//the write count up to which a reader has read, the writer does not overwrite beyond it while readers are attached
+		std::atomic<uint64_t> readCount;
+		std::atomic<uint64_t> droppedCount;
+		std::atomic<uint32_t> numReaders;
+		std::atomic<uint32_t> closed;
+	};
+
+	//a slot is being written while its sequence is odd
+	struct Slot {
+		std::atomic<uint64_t> sequence;
+		std::atomic<uint32_t> frame;
+		uint32_t reserved;
+		//the write count of the frame in the slot
+		std::atomic<uint64_t> count;
+	};
+
+	static const uint64_t ALIGNMENT = 64;
+
+	static uint64_t getOffset(uint64_t bytes) { return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+	Header *getHeader() const { return reinterpret_cast<Header*>(mMemory.getData()); }
+	Slot *getSlot(uint32_t index) const;
+	uint8_t *getPixels(uint32_t index) const { return reinterpret_cast<uint8_t*>(getSlot(index)) + getOffset(sizeof(Slot)); }
+
+	bool tryRead(uint32_t frame, cinder::Surface *surface) const;
+
+	SharedMemory mMemory;
+	bool mWriter = false;
+	uint64_t mId = 0;
+	//the read count when the reader last failed to keep up, it is not waited for again until it reads something
+	uint64_t mStalledReadCount = UINT64_MAX;
+};
+
+}
\ No newline at end of file
@@ -28,11 +28,14 @@
 #include "cinder/Timeline.h"
 #include "cinder/Vector.h"
 #include "cinder/Color.h"
+#include "cinder/Surface.h"
 #include "cinder/gl/gl.h"
 #include <string>
 #include <vector>
 
 #include "CameraAE.h"
+#include "CounterRand.h"
+#include "TimelineAE.h"
 
 namespace atarabi {
 
@@ -44,7 +47,12 @@ enum class ParameterType {
 	Slider,
 	Point,
 	Point3D,
-	Color
+	Color,
+	Angle,
+	Integer,
+	Popup,
+	ColorA,
+	FloatArray
 };
 
 union ParameterValue {
@@ -68,6 +76,23 @@ union ParameterValue {
 		float r, g, b;
 	} color;
 
+	struct {
+		float value;
+	} angle;
+
+	struct {
+		int32_t value;
+	} integer;
+
+	//! 0-based index of the selected option.
+	struct {
+		int32_t value;
+	} popup;
+
+	struct {
+		float r, g, b, a;
+	} colorA;
+
 	ParameterValue() {}
 
 	ParameterValue(bool value)
@@ -124,6 +149,36 @@ union ParameterValue {
 	{
 		return{ color.r, color.g, color.b };
 	}
+
+	ParameterValue(int32_t value)
+	{
+		integer.value = value;
+	}
+
+	operator int32_t() const
+	{
+		return integer.value;
+	}
+
+	ParameterValue(const cinder::ColorA &value)
+	{
+		colorA.r = value.r;
+		colorA.g = value.g;
+		colorA.b = value.b;
+		colorA.a = value.a;
+	}
+
+	operator cinder::ColorA() const
+	{
+		return{ colorA.r, colorA.g, colorA.b, colorA.a };
+	}
+};
+
+/*
+* Identifies a parameter set by setParameter, so that it can be set without looking up its name.
+*/
+struct SetterHandle {
+	uint32_t id;
 };
 
 /*
@@ -131,15 +186,16 @@ union ParameterValue {
 */
 class IAppAE : public cinder::app::App {
 public:
-	IAppAE() : mTimelineAE{ cinder::Timeline::create() } {}
+	IAppAE() : mTimelineAE{ TimelineAE::create() } {}
 
 	//! Override to perform any application setup.
 	virtual void initializeAE() {}
 	//! Override to perform any rendering setup.
 	virtual void setupAE() {}
-	//! Override to perform any once-per-loop computation.
+	//! Override to perform any once-per-loop computation. It runs once per frame, also when the frame is rendered with motion blur.
 	virtual void updateAE() {}
 	//! Override to perform any rendering once-per-loop.
+	//! With motion blur it is called for each sub-frame, where getCurrentTime(), getParameter(), getCameraParameter() and timelineAE() follow the sub-frame, setters are ignored and getRand() returns the numbers of the frame.
 	virtual void drawAE() {}
 
 	//! Override to receive mouse-down events.
@@ -154,7 +210,7 @@ public:
 	virtual void mouseDragAE(cinder::app::MouseEvent event) {}
 
 	//! Returns a reference to the AppAE's Timeline
-	cinder::Timeline& timelineAE() { return *mTimelineAE; }
+	TimelineAE& timelineAE() { return *mTimelineAE; }
 
 protected:
 	//! Returns the fps of the composition.
@@ -165,6 +221,8 @@ protected:
 	virtual uint32_t getCurrentFrame() const = 0;
 	//! Returns the number of seconds.
 	virtual float getCurrentTime() const = 0;
+	//! Returns the offset of the sub-frame being rendered from the current frame, in frames(it is not 0 only while rendering motion blur).
+	virtual float getSubFrame() const { return 0.f; }
 
 	//! Returns the width of the layer.
 	virtual int getWidth() const = 0;
@@ -172,12 +230,23 @@ protected:
 	virtual int getHeight() const = 0;
 	//! Returns the size of the layer.
 	virtual cinder::ivec2 getSize() const = 0;
+	//! Returns the fraction of the layer size rendered for a draft(1 without a proxy), getSize() and the parameters are already scaled by it.
+	virtual float getProxyScale() const { return 1.f; }
 
 	//! Returns the path of the selected AV layer's source(it can be empty).
 	virtual std::string getSourcePath() const = 0;
 	//! Returns the start time of the selected AV layer's source.
 	virtual float getSourceTime() const = 0;
 
+	//! Returns the pixels of the selected AV layer at the frame, shared by After Effects without encoding.
+	//! Each frame gets its own surface. It is empty when nothing is shared, or when the frame did not arrive within a second, which is counted and reported when rendering ends.
+	//! The frames keep the full layer size under a proxy, so draw them into getSize() or scale pixel positions by getProxyScale().
+	virtual cinder::Surface getLayerSurface(uint32_t frame) = 0;
+	cinder::Surface getLayerSurface() { return getLayerSurface(getCurrentFrame()); }
+	//! Returns the pixels of the selected AV layer at the frame as a texture(it can be nullptr).
+	virtual cinder::gl::TextureRef getLayerTexture(uint32_t frame) = 0;
+	cinder::gl::TextureRef getLayerTexture() { return getLayerTexture(getCurrentFrame()); }
+
 	//! Adds a parameter(control effect) to After Effects(must be called in initializeAE()).
 	virtual void addParameter(const std::string &name, ParameterType type, ParameterValue initialValue) = 0;
 	void addParameter(const std::string &name, bool initialValue) { addParameter(name, ParameterType::Checkbox, initialValue); }
@@ -185,17 +254,39 @@ protected:
 	void addParameter(const std::string &name, cinder::vec2 initialValue){ addParameter(name, ParameterType::Point, initialValue); }
 	void addParameter(const std::string &name, cinder::vec3 initialValue) { addParameter(name, ParameterType::Point3D, initialValue); }
 	void addParameter(const std::string &name, cinder::Color initialValue) { addParameter(name, ParameterType::Color, initialValue); }
+	void addParameter(const std::string &name, int32_t initialValue) { addParameter(name, ParameterType::Integer, initialValue); }
+	void addParameter(const std::string &name, cinder::ColorA initialValue) { addParameter(name, ParameterType::ColorA, initialValue); }
+	//! Adds an angle parameter, whose value is in degrees.
+	void addAngleParameter(const std::string &name, float initialValue) { addParameter(name, ParameterType::Angle, initialValue); }
+	//! Adds a popup parameter, whose value is the index of the selected option.
+	virtual void addParameter(const std::string &name, const std::vector<std::string> &options, int32_t initialValue) = 0;
+	//! Adds a parameter holding any number of floats, e.g. the points of a curve or the stops of a gradient.
+	virtual void addParameter(const std::string &name, const std::vector<float> &initialValue) = 0;
+
+	//! Sets the seed of getRand().
+	void setRandSeed(uint64_t seed) { mRandSeed = seed; }
+	//! Returns random numbers determined by the seed, the frame and the stream alone, e.g. a stream per emitter or per thread.
+	CounterRand getRand(uint32_t stream, uint32_t frame) const { return CounterRand{ mRandSeed, frame, stream }; }
+	CounterRand getRand(uint32_t stream = 0) const { return getRand(stream, getCurrentFrame()); }
 
 	//! Adds a "CameraAE" plugin to AfterEffects to get information about the camera used in AfterEffects.
 	void addCameraParameter() { mUseCamera = true; }
 
 	//! Returns the value of the added parameter.
 	virtual ParameterValue getParameter(const std::string &name, uint32_t frame) const = 0;
-	ParameterValue getParameter(const std::string &name) const { return getParameter(name, getCurrentFrame()); }
+	ParameterValue getParameter(const std::string &name) const { return getSubFrame() == 0.f ? getParameter(name, getCurrentFrame()) : getParameterAt(name, getCurrentFrame() + getSubFrame()); }
+	//! Returns the value of the added parameter at a fractional frame, interpolating the numeric parameters linearly.
+	virtual ParameterValue getParameterAt(const std::string &name, float frame) const { return getParameter(name, frame > 0.f ? static_cast<uint32_t>(frame) : 0); }
+
+	//! Returns the values of the added float array parameter.
+	virtual std::vector<float> getArrayParameter(const std::string &name, uint32_t frame) const = 0;
+	std::vector<float> getArrayParameter(const std::string &name) const { return getArrayParameter(name, getCurrentFrame()); }
 
 	//! Returns the value of the "CamerAE" plugin.
 	virtual CameraAE::Parameter getCameraParameter(uint32_t frame) const = 0;
-	CameraAE::Parameter getCameraParameter() const { return getCameraParameter(getCurrentFrame()); }
+	CameraAE::Parameter getCameraParameter() const { return getSubFrame() == 0.f ? getCameraParameter(getCurrentFrame()) : getCameraParameterAt(getCurrentFrame() + getSubFrame()); }
+	//! Returns the value of the "CamerAE" plugin at a fractional frame.
+	virtual CameraAE::Parameter getCameraParameterAt(float frame) const { return getCameraParameter(frame > 0.f ? static_cast<uint32_t>(frame) : 0); }
 
 	//! Sets the value of the parameter which will be baked in After Effects after rendering images.
 	virtual void setParameter(const std::string &name, ParameterType type, ParameterValue value, uint32_t frame) {}
@@ -211,6 +302,15 @@ protected:
 	void setParameter(const std::string &name, cinder::Color value, uint32_t frame) { setParameter(name, ParameterType::Color, value, frame); }
 	void setParameter(const std::string &name, cinder::Color value) { setParameter(name, ParameterType::Color, value, getCurrentFrame()); }
 
+	//! Returns the handle of the parameter to set, which is cheaper than passing its name every frame.
+	virtual SetterHandle getSetterHandle(const std::string &name, ParameterType type) { return SetterHandle{ 0 }; }
+	virtual void setParameter(SetterHandle handle, ParameterValue value, uint32_t frame) {}
+	void setParameter(SetterHandle handle, ParameterValue value) { setParameter(handle, value, getCurrentFrame()); }
+
+	//! Simplifies the baked values of the parameter before sending them, dropping the frames which linear interpolation reproduces within tolerance.
+	//! The kept keyframes must be interpolated linearly in AE, for points this includes spatial interpolation(see README).
+	virtual void setParameterTolerance(const std::string &name, float tolerance) {}
+
 	//! Sets the values of the camera which will be baked in After Effects after rendering images.
 	virtual void setCameraParameter(const cinder::Camera &camera) {}
 
@@ -220,11 +320,18 @@ protected:
 	//! Decides whether to unpremultiply surface or not when writing out an image sequence.
 	virtual void setUnmultiply(bool unmultiply) {}
 
+	//! Decides whether to repeat frames identical to the previous one instead of writing them again(off by default, since every frame is hashed).
+	virtual void setDeduplicate(bool deduplicate) {}
+
+	//! Declares the area(in the pixels of getSize()) which changed since the previous frame, so that drawing is scissored to it and only it is read back(call it in updateAE(), the whole frame by default).
+	virtual void setDirtyRect(const cinder::Area &area) {}
+
 protected:
 	bool mUseCamera = false;
+	uint64_t mRandSeed = 0;
 
 private:
-	std::shared_ptr<cinder::Timeline> mTimelineAE;
+	TimelineAERef mTimelineAE;
 
 };
 
@@ -23,6 +23,8 @@
 */
 
 #include "ImageSequenceLoader.h"
+#include "TextureStreamer.h"
+#include "FrameCache.h"
 
 // avoid struct nil error
 #if defined(__APPLE__)
@@ -31,13 +33,213 @@
 #endif
 #include <boost/xpressive/xpressive.hpp>
 
+#include "cinder/Thread.h"
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
+
 namespace atarabi {
 
+/*
+* Prefetcher
+*/
+class ImageSequenceLoader::Prefetcher {
+	struct Entry {
+		cinder::Surface surface;
+		std::size_t bytes;
+		std::list<int32_t>::iterator lru;
+	};
+
+public:
+	struct Job {
+		int32_t index;
+		cinder::fs::path path;
+	};
+
+	Prefetcher(std::size_t maxBytes, int numThreads);
+	~Prefetcher();
+
+	bool find(int32_t index, cinder::Surface *surface);
+	void insert(int32_t index, const cinder::Surface &surface);
+	void request(std::vector<Job> &&jobs);
+	void clear();
+
+private:
+	void run();
+	void insertLocked(int32_t index, const cinder::Surface &surface);
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::deque<Job> mJobs;
+	std::unordered_set<int32_t> mInFlight;
+	std::list<int32_t> mLru;
+	std::unordered_map<int32_t, Entry> mEntries;
+	std::size_t mBytes = 0;
+	std::size_t mMaxBytes;
+	uint32_t mGeneration = 0;
+	bool mAbort = false;
+	std::vector<std::thread> mThreads;
+};
+
+ImageSequenceLoader::Prefetcher::Prefetcher(std::size_t maxBytes, int numThreads) : mMaxBytes{ maxBytes }
+{
+	for (int i = 0; i < numThreads; ++i)
+	{
+		mThreads.emplace_back(std::bind(&Prefetcher::run, this));
+	}
+}
+
+ImageSequenceLoader::Prefetcher::~Prefetcher()
+{
+	{
+		std::lock_guard<std::mutex> lock{ mMutex };
+		mAbort = true;
+		mJobs.clear();
+	}
+	mCondition.notify_all();
+
+	for (auto &thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+bool ImageSequenceLoader::Prefetcher::find(int32_t index, cinder::Surface *surface)
+{
+	std::lock_guard<std::mutex> lock{ mMutex };
+
+	auto it = mEntries.find(index);
+	if (it == mEntries.end())
+	{
+		return false;
+	}
+
+	auto &entry = it->second;
+	mLru.splice(mLru.begin(), mLru, entry.lru);
+	*surface = entry.surface;
+	return true;
+}
+
+void ImageSequenceLoader::Prefetcher::insert(int32_t index, const cinder::Surface &surface)
+{
+	std::lock_guard<std::mutex> lock{ mMutex };
+	insertLocked(index, surface);
+}
+
+void ImageSequenceLoader::Prefetcher::insertLocked(int32_t index, const cinder::Surface &surface)
+{
+	if (mEntries.count(index) > 0)
+	{
+		return;
+	}
+
+	std::size_t bytes = static_cast<std::size_t>(surface.getRowBytes()) * surface.getHeight();
+	mLru.push_front(index);
+	mEntries.insert(std::make_pair(index, Entry{ surface, bytes, mLru.begin() }));
+	mBytes += bytes;
+
+	//evict the least recently used surfaces, but always keep the newest one
+	while (mBytes > mMaxBytes && mLru.size() > 1)
+	{
+		auto last = mEntries.find(mLru.back());
+		mBytes -= last->second.bytes;
+		mEntries.erase(last);
+		mLru.pop_back();
+	}
+}
+
+void ImageSequenceLoader::Prefetcher::request(std::vector<Job> &&jobs)
+{
+	{
+		std::lock_guard<std::mutex> lock{ mMutex };
+
+		//the newest access pattern wins, stale requests are dropped
+		mJobs.clear();
+		for (auto &job : jobs)
+		{
+			if (mEntries.count(job.index) == 0 && mInFlight.count(job.index) == 0)
+			{
+				mJobs.push_back(std::move(job));
+			}
+		}
+	}
+	mCondition.notify_all();
+}
+
+void ImageSequenceLoader::Prefetcher::clear()
+{
+	std::lock_guard<std::mutex> lock{ mMutex };
+	++mGeneration;
+	mJobs.clear();
+	mInFlight.clear();
+	mLru.clear();
+	mEntries.clear();
+	mBytes = 0;
+}
+
+void ImageSequenceLoader::Prefetcher::run()
+{
+	cinder::ThreadSetup threadSetup;
+
+	while (true)
+	{
+		Job job;
+		uint32_t generation;
+		{
+			std::unique_lock<std::mutex> lock{ mMutex };
+			mCondition.wait(lock, [this]() -> bool { return mAbort || !mJobs.empty(); });
+
+			if (mAbort)
+			{
+				break;
+			}
+
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+			mInFlight.insert(job.index);
+			generation = mGeneration;
+		}
+
+		cinder::Surface surface;
+		try
+		{
+			surface = cinder::Surface{ cinder::loadImage(job.path) };
+		}
+		catch (...)
+		{
+			//pass
+		}
+
+		std::lock_guard<std::mutex> lock{ mMutex };
+		if (generation == mGeneration)
+		{
+			mInFlight.erase(job.index);
+			if (surface.getData())
+			{
+				insertLocked(job.index, surface);
+			}
+		}
+	}
+}
+
+/*
+* ImageSequenceLoader
+*/
+ImageSequenceLoader::ImageSequenceLoader() {}
+
 ImageSequenceLoader::ImageSequenceLoader(const std::string &firstImagePath)
 {
 	load(firstImagePath);
 }
 
+ImageSequenceLoader::~ImageSequenceLoader() {}
+
 void ImageSequenceLoader::load(const std::string &firstImagePath)
 {
 	static boost::xpressive::sregex regex = boost::xpressive::sregex::compile("(\\d+)\\.(png|tiff|tif|jpg|jpeg|bmp)$", boost::xpressive::regex_constants::icase);
@@ -56,37 +258,234 @@ void ImageSequenceLoader::load(const std::string &firstImagePath)
 	if (boost::xpressive::regex_search(firstImageName, match, regex))
 	{
 		std::string prefix = firstImageName.substr(0, firstImageName.size() - match[0].str().size());
-		std::string suffix = match[2].str();
-
-		boost::xpressive::sregex sequenceRegex = boost::xpressive::sregex::compile("^" + prefix + "\\d+\\." + suffix + "$");
+		std::string suffix = "." + match[2].str();
+		std::size_t padding = match[1].str().size();
 
 		mParentPath = mFirstImagePath.parent_path();
-		for (cinder::fs::directory_iterator it{ mParentPath }, last{}; it != last; ++it)
+		mIndex = loadIndex(mParentPath, prefix, suffix, padding);
+
+		if (!mFrameCacheDirectory.empty() && !empty())
 		{
-			const auto &entry = *it;
-			const auto &file = entry.path();
-			if (cinder::fs::is_regular_file(file))
-			{
-				std::string filename = file.filename().string();
-				if (boost::xpressive::regex_match(filename, match, sequenceRegex))
-				{
-					mFileNames.push_back(filename);
-				}
-			}
+			loadFrameCache(prefix, suffix);
+		}
+	}
+}
+
+void ImageSequenceLoader::loadFrameCache(const std::string &prefix, const std::string &suffix)
+{
+	std::vector<cinder::fs::path> files;
+	files.reserve(mIndex->fileNames.size());
+	for (const auto &fileName : mIndex->fileNames)
+	{
+		files.push_back(mParentPath / fileName);
+	}
+
+	//one cache file per sequence, named after its prefix, suffix and directory(e.g. shot_.png and shot_.exr share a prefix)
+	std::string parent = mParentPath.string();
+	std::size_t hash = std::hash<std::string>{}(parent + "*" + suffix);
+	std::stringstream ss;
+	ss << prefix << std::hex << hash << suffix << ".framecache";
+	cinder::fs::path cachePath = cinder::fs::path{ mFrameCacheDirectory } / ss.str();
+
+	try
+	{
+		if (!cinder::fs::exists(mFrameCacheDirectory))
+		{
+			cinder::fs::create_directories(mFrameCacheDirectory);
+		}
+
+		uint64_t signature = FrameCache::getSignature(files);
+		mFrameCache = FrameCache::open(cachePath, signature, files.size());
+		if (!mFrameCache)
+		{
+			mFrameCache = FrameCache::create(cachePath, signature, files);
+		}
+	}
+	catch (...)
+	{
+		//fall back to decoding each image
+		mFrameCache.reset();
+	}
+}
+
+std::shared_ptr<const ImageSequenceLoader::Index> ImageSequenceLoader::loadIndex(const cinder::fs::path &parentPath, const std::string &prefix, const std::string &suffix, std::size_t padding)
+{
+	static std::mutex mutex;
+	static std::map<std::string, std::shared_ptr<const Index>> cache;
+
+	std::time_t modifiedTime = cinder::fs::last_write_time(parentPath);
+	//the padding decides which file wins when the same number is written differently
+	std::string key = parentPath.string() + "/" + prefix + "*" + suffix + "#" + std::to_string(padding);
+
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto it = cache.find(key);
+		//adding, removing or renaming a file updates the directory's modification time
+		if (it != cache.end() && it->second->modifiedTime == modifiedTime)
+		{
+			return it->second;
+		}
+	}
+
+	struct Entry {
+		int32_t number;
+		std::size_t padding;
+		std::string fileName;
+	};
+
+	std::vector<Entry> entries;
+	for (cinder::fs::directory_iterator it{ parentPath }, last{}; it != last; ++it)
+	{
+		const auto &file = it->path();
+		std::string fileName = file.filename().string();
+
+		if (fileName.size() <= prefix.size() + suffix.size()
+			|| fileName.compare(0, prefix.size(), prefix) != 0
+			|| fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) != 0)
+		{
+			continue;
+		}
+
+		//parse the frame number once, rejecting anything but digits between the prefix and the suffix
+		std::size_t digits = fileName.size() - prefix.size() - suffix.size();
+		int64_t number = 0;
+		bool valid = digits <= 9;
+		for (std::size_t i = prefix.size(), last = i + digits; valid && i < last; ++i)
+		{
+			char c = fileName[i];
+			valid = c >= '0' && c <= '9';
+			number = number * 10 + (c - '0');
+		}
+
+		if (valid && cinder::fs::is_regular_file(file))
+		{
+			entries.push_back(Entry{ static_cast<int32_t>(number), digits, std::move(fileName) });
+		}
+	}
+
+	//sort by frame number, preferring the padding of the first image when the same number is written differently
+	std::sort(entries.begin(), entries.end(), [padding](const Entry &lhs, const Entry &rhs) -> bool {
+		if (lhs.number != rhs.number)
+		{
+			return lhs.number < rhs.number;
+		}
+		return (lhs.padding == padding) > (rhs.padding == padding);
+	});
+	entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry &lhs, const Entry &rhs) -> bool {
+		return lhs.number == rhs.number;
+	}), entries.end());
+
+	auto index = std::make_shared<Index>();
+	index->modifiedTime = modifiedTime;
+
+	if (!entries.empty())
+	{
+		index->firstNumber = entries.front().number;
+		index->numFrames = entries.back().number - entries.front().number + 1;
+		//one slot per file, the numbers may be far apart
+		index->fileNames.reserve(entries.size());
+		index->frames.reserve(entries.size());
+
+		for (auto &entry : entries)
+		{
+			index->frames.push_back(entry.number - index->firstNumber);
+			index->fileNames.push_back(std::move(entry.fileName));
 		}
 	}
+
+	std::lock_guard<std::mutex> lock{ mutex };
+	cache[key] = index;
+
+	return index;
 }
 
 void ImageSequenceLoader::reset()
 {
-	mFileNames.clear();
-	mFileNames.shrink_to_fit();
+	mIndex.reset();
+	mFrameCache.reset();
+	mLastFrame = 0;
+	mDirection = 1;
+
+	if (mPrefetcher)
+	{
+		mPrefetcher->clear();
+	}
+}
+
+void ImageSequenceLoader::setPrefetch(int numFrames, std::size_t maxBytes, int numThreads)
+{
+	//the app decodes a frame itself when it was not prefetched in time
+	if (numThreads <= 0)
+	{
+		numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+	}
+
+	mPrefetchFrames = std::max(0, numFrames);
+	mPrefetcher.reset();
+	mPrefetcher.reset(new Prefetcher{ maxBytes, numThreads });
+}
+
+void ImageSequenceLoader::disablePrefetch()
+{
+	mPrefetchFrames = 0;
+	mPrefetcher.reset();
 }
 
 cinder::ImageSourceRef ImageSequenceLoader::getImage(int32_t frame) const
 {
-	assert(!mFileNames.empty());
+	assert(!empty());
+
+	int32_t index = getIndex(frame);
+	if (mFrameCache && mFrameCache->hasFrame(getFile(index)))
+	{
+		return mFrameCache->getSurface(getFile(index));
+	}
+
+	return cinder::loadImage(getFilePath(index));
+}
+
+cinder::Surface ImageSequenceLoader::getSurface(int32_t frame)
+{
+	assert(!empty());
+
+	if (mFrameCache && mFrameCache->hasFrame(getFile(getIndex(frame))))
+	{
+		return mFrameCache->getSurface(getFile(getIndex(frame)));
+	}
+
+	//the frames the cache dropped are decoded here, the others come from the cache
+	if (!mPrefetcher || mFrameCache)
+	{
+		return cinder::Surface{ getImage(frame) };
+	}
+
+	//cache by file, so held frames share one decoded surface
+	int32_t index = getFile(getIndex(frame));
+
+	cinder::Surface surface;
+	if (!mPrefetcher->find(index, &surface))
+	{
+		surface = cinder::Surface{ getImage(frame) };
+		mPrefetcher->insert(index, surface);
+	}
+
+	prefetch(frame);
+
+	return surface;
+}
+
+cinder::gl::TextureRef ImageSequenceLoader::getTexture(int32_t frame)
+{
+	if (!mTextureStreamer)
+	{
+		mTextureStreamer.reset(new TextureStreamer{});
+	}
 
+	return mTextureStreamer->update(getSurface(frame));
+}
+
+int32_t ImageSequenceLoader::getIndex(int32_t frame) const
+{
 	int32_t numFrames = getNumFrames();
 
 	if (mLoop)
@@ -109,10 +508,49 @@ cinder::ImageSourceRef ImageSequenceLoader::getImage(int32_t frame) const
 			frame = numFrames - 1;
 		}
 	}
-	
-	const std::string &filename = mFileNames[frame];
 
-	return cinder::loadImage(mParentPath / filename);
+	return frame;
+}
+
+int32_t ImageSequenceLoader::getFile(int32_t index) const
+{
+	//the last file at or before index, the first one is at 0
+	const auto &frames = mIndex->frames;
+	return static_cast<int32_t>(std::upper_bound(frames.begin(), frames.end(), index) - frames.begin()) - 1;
+}
+
+void ImageSequenceLoader::prefetch(int32_t frame)
+{
+	//infer the direction from the requested frames, so a looped sequence keeps reading ahead across the wrap-around
+	if (frame != mLastFrame)
+	{
+		mDirection = frame > mLastFrame ? 1 : -1;
+	}
+	mLastFrame = frame;
+
+	std::vector<Prefetcher::Job> jobs;
+	jobs.reserve(mPrefetchFrames);
+
+	int32_t current = getIndex(frame);
+	int32_t previous = current;
+	for (int i = 1; i <= mPrefetchFrames; ++i)
+	{
+		int32_t index = getIndex(frame + i * mDirection);
+		if (index == current || index == previous)
+		{
+			//clamped at either end or wrapped around a short sequence
+			break;
+		}
+		previous = index;
+
+		int32_t file = getFile(index);
+		if (file != getFile(current) && (jobs.empty() || jobs.back().index != file))
+		{
+			jobs.push_back(Prefetcher::Job{ file, getFilePath(index) });
+		}
+	}
+
+	mPrefetcher->request(std::move(jobs));
 }
 
 }
\ No newline at end of file
@@ -26,16 +26,32 @@
 
 #include "cinder/Filesystem.h"
 #include "cinder/ImageIo.h"
+#include "cinder/Surface.h"
+#include "cinder/gl/Texture.h"
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <ctime>
 
 namespace atarabi {
 
+class TextureStreamer;
+class FrameCache;
+
 class ImageSequenceLoader {
+	class Prefetcher;
+
 public:
-	ImageSequenceLoader() {}
+	static const int DEFAULT_PREFETCH_FRAMES = 8;
+	static const std::size_t DEFAULT_CACHE_BYTES = 512 * 1024 * 1024;
+
+	ImageSequenceLoader();
 	ImageSequenceLoader(const std::string &firstImagePath);
+	~ImageSequenceLoader();
+
+	ImageSequenceLoader(const ImageSequenceLoader &) = delete;
+	ImageSequenceLoader &operator=(const ImageSequenceLoader &) = delete;
 
 	void load(const std::string &firstImagePath);
 	void reset();
@@ -43,15 +59,57 @@ public:
 	void setLoop(bool loop) { mLoop = loop; }
 	bool isLoop() const { return mLoop; }
 
-	bool empty() const { return mFileNames.empty(); }
-	int32_t getNumFrames() const { return static_cast<int32_t>(mFileNames.size()); }
+	//! Transcodes each loaded sequence once into a memory-mapped file of raw frames in directory, which later loads map instead of decoding(empty disables it).
+	void setFrameCache(const std::string &directory) { mFrameCacheDirectory = directory; }
+	bool isFrameCache() const { return mFrameCache != nullptr; }
+
+	//! Enables read-ahead decoding of the next numFrames frames on numThreads workers(0 means one fewer than the number of cores, leaving one to the app), keeping at most maxBytes of decoded surfaces.
+	void setPrefetch(int numFrames = DEFAULT_PREFETCH_FRAMES, std::size_t maxBytes = DEFAULT_CACHE_BYTES, int numThreads = 0);
+	//! Disables read-ahead decoding and releases the cached surfaces.
+	void disablePrefetch();
+	bool isPrefetch() const { return mPrefetcher != nullptr; }
+
+	bool empty() const { return !mIndex || mIndex->fileNames.empty(); }
+	//! Returns the number of frames from the first to the last number, missing frames included.
+	int32_t getNumFrames() const { return mIndex ? mIndex->numFrames : 0; }
+	//! Returns the number written in the first file name of the sequence.
+	int32_t getFirstFrameNumber() const { return mIndex ? mIndex->firstNumber : 0; }
 	cinder::ImageSourceRef getImage(int32_t frame) const;
+	//! Returns the decoded image, immediately if it has already been prefetched.
+	cinder::Surface getSurface(int32_t frame);
+	//! Returns the image uploaded to one of a few reused textures through pixel buffers(must be called on the GL thread).
+	cinder::gl::TextureRef getTexture(int32_t frame);
 
 protected:
+	struct Index {
+		std::time_t modifiedTime = 0;
+		int32_t firstNumber = 0;
+		int32_t numFrames = 0;
+		std::vector<std::string> fileNames;
+		//the frame of each file, ascending, a missing frame holds the file before it
+		std::vector<int32_t> frames;
+	};
+
+	static std::shared_ptr<const Index> loadIndex(const cinder::fs::path &parentPath, const std::string &prefix, const std::string &suffix, std::size_t padding);
+
+	void loadFrameCache(const std::string &prefix, const std::string &suffix);
+	int32_t getIndex(int32_t frame) const;
+	//! Returns the file shown at index(from getIndex()).
+	int32_t getFile(int32_t index) const;
+	cinder::fs::path getFilePath(int32_t index) const { return mParentPath / mIndex->fileNames[getFile(index)]; }
+	void prefetch(int32_t frame);
+
 	bool mLoop = false;
+	int mPrefetchFrames = 0;
+	int32_t mLastFrame = 0;
+	int mDirection = 1;
+	std::unique_ptr<Prefetcher> mPrefetcher;
+	std::unique_ptr<TextureStreamer> mTextureStreamer;
 	cinder::fs::path mFirstImagePath;
 	cinder::fs::path mParentPath;
-	std::vector<std::string> mFileNames;
+	std::shared_ptr<const Index> mIndex;
+	std::string mFrameCacheDirectory;
+	std::shared_ptr<FrameCache> mFrameCache;
 };
 
 }
\ No newline at end of file
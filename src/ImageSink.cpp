@@ -0,0 +1,410 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "ImageSink.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Filesystem.h"
+#include "cinder/ip/Flip.h"
+#include "cinder/ip/Premultiply.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <csignal>
+#include <chrono>
+#include <limits>
+
+#if defined(CINDER_MSW)
+	#define popen _popen
+	#define pclose _pclose
+#endif
+
+namespace atarabi {
+
+namespace {
+
+const char MAGIC[8] = { 'C', 'I', 'A', 'E', 'F', 'R', 'M', 'C' };
+
+} //anonymous namespace
+
+void FileSink::write(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied)
+{
+	//a file left by the previous render may be a hard link to another frame, writing through it would change that frame too
+	cinder::fs::remove(path);
+	cinder::writeImage(path, surface);
+}
+
+bool FileSink::writeDuplicate(uint32_t frame, const std::string &path, uint32_t sourceFrame, const std::string &sourcePath)
+{
+	//a file left by the previous render
+	try
+	{
+		cinder::fs::remove(path);
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	try
+	{
+		cinder::fs::create_hard_link(sourcePath, path);
+		return true;
+	}
+	catch (...)
+	{
+		//e.g. FAT32 or a network drive
+	}
+
+	try
+	{
+		cinder::fs::copy_file(sourcePath, path);
+		return true;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+const int ContainerSink::VERSION;
+
+ContainerSink::ContainerSink(const std::string &path) : mStream{ path.c_str(), std::ios::binary | std::ios::trunc }
+{
+	if (!mStream)
+	{
+		return;
+	}
+
+	Header header;
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.reserved = 0;
+	mStream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	mFailed = !mStream;
+}
+
+void ContainerSink::write(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied)
+{
+	writeCropped(frame, path, surface, flipped, premultiplied, cinder::ivec2{ 0, 0 }, surface.getSize());
+}
+
+void ContainerSink::writeCropped(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied, const cinder::ivec2 &offset, const cinder::ivec2 &frameSize)
+{
+	Record record;
+	record.frame = frame;
+	record.flags = (flipped ? FLIPPED : 0) | (premultiplied ? PREMULTIPLIED : 0);
+	record.width = surface.getWidth();
+	record.height = surface.getHeight();
+	record.rowBytes = static_cast<int32_t>(surface.getRowBytes());
+	record.channelOrder = surface.getChannelOrder().getCode();
+	record.x = offset.x;
+	record.y = offset.y;
+	record.frameWidth = frameSize.x;
+	record.frameHeight = frameSize.y;
+	record.bytes = static_cast<uint64_t>(record.rowBytes) * record.height;
+
+	//records may arrive out of order, a reader sorts them by frame
+	std::lock_guard<std::mutex> lock{ mMutex };
+	if (mFailed)
+	{
+		return;
+	}
+
+	mStream.write(reinterpret_cast<const char*>(&record), sizeof(Record));
+	mStream.write(reinterpret_cast<const char*>(surface.getData()), record.bytes);
+
+	//a partly written record ends the file, ContainerReader stops at it
+	if (!mStream)
+	{
+		mFailed = true;
+	}
+}
+
+void ContainerSink::close()
+{
+	std::lock_guard<std::mutex> lock{ mMutex };
+	mStream.flush();
+	if (!mStream)
+	{
+		mFailed = true;
+	}
+}
+
+ContainerReader::ContainerReader(const std::string &path) : mStream{ path.c_str(), std::ios::binary }
+{
+	ContainerSink::Header header;
+	if (!mStream.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != ContainerSink::VERSION)
+	{
+		return;
+	}
+
+	mStream.seekg(0, std::ios::end);
+	uint64_t size = static_cast<uint64_t>(mStream.tellg());
+	uint64_t offset = sizeof(header);
+
+	//index the records, the pixels are only read when a frame is requested
+	while (offset + sizeof(ContainerSink::Record) <= size)
+	{
+		Entry entry;
+		mStream.seekg(offset);
+		if (!mStream.read(reinterpret_cast<char*>(&entry.record), sizeof(entry.record)))
+		{
+			break;
+		}
+
+		const auto &record = entry.record;
+		entry.offset = offset + sizeof(record);
+		bool valid = record.width > 0 && record.height > 0 && record.rowBytes > 0 && record.bytes == static_cast<uint64_t>(record.rowBytes) * record.height
+			&& record.x >= 0 && record.y >= 0 && record.x + record.width <= record.frameWidth && record.y + record.height <= record.frameHeight;
+		if (!valid || entry.offset + record.bytes > size)
+		{
+			break;
+		}
+
+		mEntries.push_back(entry);
+		offset = entry.offset + record.bytes;
+	}
+
+	std::stable_sort(mEntries.begin(), mEntries.end(), [](const Entry &lhs, const Entry &rhs) -> bool {
+		return lhs.record.frame < rhs.record.frame;
+	});
+
+	mOpen = true;
+}
+
+cinder::Surface ContainerReader::getSurface(int32_t index)
+{
+	assert(index >= 0 && index < getNumFrames());
+
+	if (index != mCurrentIndex)
+	{
+		//go back to the last whole frame, or only to the current frame when the records in between are cropped onto it
+		int32_t first = index;
+		while (first > 0 && !isWhole(mEntries[first].record) && first - 1 != mCurrentIndex)
+		{
+			--first;
+		}
+
+		bool resume = mCurrentIndex >= 0 && first - 1 == mCurrentIndex;
+		if (!resume && !isWhole(mEntries[first].record))
+		{
+			//nothing was written before the first record, the rest of the frame is transparent
+			clear(mEntries[first].record);
+		}
+
+		for (int32_t i = first; i <= index; ++i)
+		{
+			if (!apply(mEntries[i]))
+			{
+				mCurrentIndex = -1;
+				return cinder::Surface{};
+			}
+			mCurrentIndex = i;
+		}
+	}
+
+	//the composite is reused for the next frame
+	return mSurface.clone();
+}
+
+bool ContainerReader::isWhole(const ContainerSink::Record &record) const
+{
+	return record.x == 0 && record.y == 0 && record.width == record.frameWidth && record.height == record.frameHeight;
+}
+
+void ContainerReader::clear(const ContainerSink::Record &record)
+{
+	mSurface = cinder::Surface{ record.frameWidth, record.frameHeight, true, cinder::SurfaceChannelOrder::RGBA };
+	std::memset(mSurface.getData(), 0, mSurface.getRowBytes() * mSurface.getHeight());
+}
+
+bool ContainerReader::apply(const Entry &entry)
+{
+	const auto &record = entry.record;
+
+	std::vector<uint8_t> pixels(static_cast<std::size_t>(record.bytes));
+	mStream.clear();
+	mStream.seekg(entry.offset);
+	if (!mStream.read(reinterpret_cast<char*>(pixels.data()), pixels.size()))
+	{
+		return false;
+	}
+
+	cinder::SurfaceChannelOrder channelOrder{ record.channelOrder };
+	if (channelOrder.getPixelInc() == 0 || record.rowBytes < record.width * channelOrder.getPixelInc())
+	{
+		return false;
+	}
+
+	cinder::Surface region{ pixels.data(), record.width, record.height, record.rowBytes, channelOrder };
+	if (record.flags & ContainerSink::FLIPPED)
+	{
+		cinder::ip::flipVertical(&region);
+	}
+	if ((record.flags & ContainerSink::PREMULTIPLIED) && region.hasAlpha())
+	{
+		cinder::ip::unpremultiply(&region);
+	}
+
+	if (!mSurface.getData() || mSurface.getWidth() != record.frameWidth || mSurface.getHeight() != record.frameHeight)
+	{
+		clear(record);
+	}
+
+	mSurface.copyFrom(region, region.getBounds(), cinder::ivec2{ record.x, record.y });
+	return true;
+}
+
+const std::size_t PipeSink::MAX_REORDER_FRAMES;
+const double PipeSink::REORDER_TIMEOUT = 5.0;
+
+PipeSink::PipeSink(const std::string &command, uint32_t firstFrame) : mNextFrame{ firstFrame }
+{
+#if defined(CINDER_MSW)
+	mPipe = ::popen(command.c_str(), "wb");
+#else
+	//an encoder which exits early would kill the app on the next write, this way fwrite fails instead
+	std::signal(SIGPIPE, SIG_IGN);
+	mPipe = ::popen(command.c_str(), "w");
+#endif
+}
+
+PipeSink::~PipeSink()
+{
+	close();
+}
+
+void PipeSink::write(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied)
+{
+	std::unique_lock<std::mutex> lock{ mMutex };
+
+	//the worker of a frame far ahead waits here, so the frames held for a missing one stay bounded
+	bool ready = mCondition.wait_for(lock, std::chrono::duration<double>(REORDER_TIMEOUT), [&]() -> bool {
+		return !mPipe || frame < mNextFrame + MAX_REORDER_FRAMES;
+	});
+
+	if (!mPipe || frame < mNextFrame)
+	{
+		return;
+	}
+
+	mReorderBuffer[frame] = surface;
+	//the missing frames are given up on rather than stalling the render
+	flush(ready ? mNextFrame : frame);
+}
+
+void PipeSink::skip(uint32_t frame)
+{
+	std::lock_guard<std::mutex> lock{ mMutex };
+
+	if (!mPipe || frame < mNextFrame)
+	{
+		return;
+	}
+
+	mReorderBuffer[frame] = cinder::Surface{};
+	flush(mNextFrame);
+}
+
+void PipeSink::close()
+{
+	std::lock_guard<std::mutex> lock{ mMutex };
+
+	if (!mPipe)
+	{
+		return;
+	}
+
+	//a frame failed to render, the rest is still better than nothing
+	flush(std::numeric_limits<uint32_t>::max());
+
+	if (::pclose(mPipe) != 0)
+	{
+		mFailed = true;
+	}
+	mPipe = nullptr;
+	mCondition.notify_all();
+}
+
+void PipeSink::flush(uint32_t upTo)
+{
+	for (auto it = mReorderBuffer.begin(); it != mReorderBuffer.end() && (it->first == mNextFrame || mNextFrame < upTo); ++mNextFrame)
+	{
+		if (it->first == mNextFrame)
+		{
+			if (it->second.getData())
+			{
+				mLastSurface = it->second;
+			}
+			it = mReorderBuffer.erase(it);
+		}
+		//a skipped or missing frame repeats the previous one
+		writeFrame(mLastSurface);
+	}
+	mCondition.notify_all();
+}
+
+void PipeSink::writeFrame(const cinder::Surface &surface)
+{
+	//until a frame has been written there is nothing to repeat
+	if (!surface.getData() || mFailed)
+	{
+		return;
+	}
+
+	int32_t width = surface.getWidth();
+	int32_t height = surface.getHeight();
+	std::size_t rowBytes = static_cast<std::size_t>(width) * 4;
+	bool written = true;
+
+	if (surface.getChannelOrder().getCode() == cinder::SurfaceChannelOrder::RGBA && static_cast<std::size_t>(surface.getRowBytes()) == rowBytes)
+	{
+		written = std::fwrite(surface.getData(), rowBytes, height, mPipe) == static_cast<std::size_t>(height);
+	}
+	else
+	{
+		cinder::Surface converted{ width, height, true, cinder::SurfaceChannelOrder::RGBA };
+		converted.copyFrom(surface, surface.getBounds());
+		for (int32_t y = 0; y < height && written; ++y)
+		{
+			written = std::fwrite(converted.getData() + converted.getRowBytes() * y, rowBytes, 1, mPipe) == 1;
+		}
+	}
+
+	//the encoder is gone, the remaining frames are dropped
+	if (!written)
+	{
+		mFailed = true;
+	}
+}
+
+void ChannelSink::write(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied)
+{
+	std::lock_guard<std::mutex> lock{ mMutex };
+	//a reader which falls behind slows the writer down briefly, then loses frames, which the channel counts
+	mChannel->write(frame, surface);
+}
+
+}
\ No newline at end of file
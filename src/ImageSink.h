@@ -0,0 +1,249 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "FrameChannel.h"
+#include "cinder/Surface.h"
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+
+namespace atarabi {
+
+/*
+* Where ImageWriter puts the rendered frames, write() is called from several workers at once.
+*/
+class ImageSink {
+public:
+	virtual ~ImageSink() {}
+
+	//! Returns whether the sink stores bottom-up rows as they are, so that the writer skips flipping them.
+	virtual bool handlesFlip() const { return false; }
+	//! Returns whether the sink stores premultiplied pixels as they are, so that the writer skips unpremultiplying them.
+	virtual bool handlesUnpremultiply() const { return false; }
+
+	//! Returns whether the sink can repeat a frame it has written without the pixels, so that the writer looks for unchanged frames.
+	virtual bool handlesDuplicates() const { return false; }
+	//! Returns whether the sink stores frames cropped to the region which changed, otherwise AppAE reads back whole frames for it.
+	virtual bool handlesCrop() const { return false; }
+
+	//! Writes the frame, flipped and premultiplied tell what the writer left to the sink.
+	virtual void write(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied) = 0;
+	//! Writes the region at offset(top-down pixels) of a frame of frameSize, only called when handlesCrop().
+	virtual void writeCropped(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied, const cinder::ivec2 &offset, const cinder::ivec2 &frameSize) { write(frame, path, surface, flipped, premultiplied); }
+	//! Repeats the already written sourceFrame as frame, returns false to have the pixels written instead.
+	virtual bool writeDuplicate(uint32_t frame, const std::string &path, uint32_t sourceFrame, const std::string &sourcePath) { return false; }
+	//! Called instead of writing a frame which failed or had no pixels.
+	virtual void skip(uint32_t frame) {}
+	//! Called once all the frames of a render have been written.
+	virtual void close() {}
+	//! Returns whether the destination stopped taking frames, e.g. the encoder exited early.
+	virtual bool hasFailed() const { return false; }
+};
+
+/*
+* Encodes a file per frame, the format follows the extension of the path.
+*/
+class FileSink : public ImageSink {
+public:
+	bool handlesDuplicates() const override { return true; }
+
+	void write(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied) override;
+	//! Hard-links the file of sourceFrame, or copies it where links are not supported.
+	bool writeDuplicate(uint32_t frame, const std::string &path, uint32_t sourceFrame, const std::string &sourcePath) override;
+};
+
+/*
+* Appends the raw frames to a single file, recording how they are stored instead of converting them.
+* A cropped frame only replaces its region of the previous frame.
+*
+* Format(little-endian): a Header, then one Record followed by its pixels per frame.
+* - Header: magic "CIAEFRMC", version, reserved.
+* - Record(48 bytes, no padding): frame, flags, width, height, rowBytes, channelOrder(cinder::SurfaceChannelOrder code), x, y(top-down offset of the region), frameWidth, frameHeight, bytes.
+* - Pixels: bytes(rowBytes * height) bytes, bottom-up rows when FLIPPED, premultiplied when PREMULTIPLIED.
+* Records are appended as the workers finish, so they are not in frame order. ContainerReader reads them back in frame order, compositing the cropped ones into whole frames.
+*/
+class ContainerSink : public ImageSink {
+public:
+	static const int VERSION = 3;
+
+	enum Flags : uint32_t {
+		FLIPPED = 1 << 0,
+		PREMULTIPLIED = 1 << 1
+	};
+
+	explicit ContainerSink(const std::string &path);
+
+	bool handlesFlip() const override { return true; }
+	bool handlesUnpremultiply() const override { return true; }
+	bool handlesCrop() const override { return true; }
+
+	void write(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied) override;
+	void writeCropped(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied, const cinder::ivec2 &offset, const cinder::ivec2 &frameSize) override;
+	void close() override;
+	//! Returns whether a write failed, e.g. the disk is full, the frames after it are dropped.
+	bool hasFailed() const override { return mFailed; }
+
+	bool isOpen() const { return mStream.is_open(); }
+
+private:
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t reserved;
+	};
+
+	struct Record {
+		uint32_t frame;
+		uint32_t flags;
+		int32_t width;
+		int32_t height;
+		int32_t rowBytes;
+		int32_t channelOrder;
+		int32_t x;
+		int32_t y;
+		int32_t frameWidth;
+		int32_t frameHeight;
+		uint64_t bytes;
+	};
+
+	//both are written as they are, so the layout must not depend on the compiler's padding
+	static_assert(sizeof(Header) == 16, "ContainerSink::Header must have no padding");
+	static_assert(sizeof(Record) == 48 && offsetof(Record, bytes) == 40, "ContainerSink::Record must have no padding");
+
+	std::mutex mMutex;
+	std::ofstream mStream;
+	std::atomic<bool> mFailed{ false };
+
+	friend class ContainerReader;
+};
+
+/*
+* Reads back the frames of a ContainerSink file in frame order, as whole top-down unpremultiplied frames.
+*/
+class ContainerReader {
+public:
+	explicit ContainerReader(const std::string &path);
+
+	//! Returns whether the file is a container of this version, a truncated last record is ignored.
+	bool isOpen() const { return mOpen; }
+	int32_t getNumFrames() const { return static_cast<int32_t>(mEntries.size()); }
+	//! Returns the frame number of the index-th frame.
+	uint32_t getFrame(int32_t index) const { return mEntries[index].record.frame; }
+	//! Returns the index-th frame, compositing cropped records onto the frames before them(sequential access only applies one record).
+	cinder::Surface getSurface(int32_t index);
+
+private:
+	struct Entry {
+		ContainerSink::Record record;
+		uint64_t offset;
+	};
+
+	bool isWhole(const ContainerSink::Record &record) const;
+	void clear(const ContainerSink::Record &record);
+	bool apply(const Entry &entry);
+
+	std::ifstream mStream;
+	std::vector<Entry> mEntries;
+	bool mOpen = false;
+	cinder::Surface mSurface;
+	int32_t mCurrentIndex = -1;
+};
+
+/*
+* Publishes the frames to a FrameChannel for a local consumer.
+*/
+class ChannelSink : public ImageSink {
+public:
+	explicit ChannelSink(std::shared_ptr<FrameChannel> channel) : mChannel{ channel } {}
+
+	void write(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied) override;
+
+private:
+	std::mutex mMutex;
+	std::shared_ptr<FrameChannel> mChannel;
+};
+
+/*
+* Streams the raw RGBA frames in order to the standard input of an encoder, e.g. ffmpeg -f rawvideo -pix_fmt rgba.
+*/
+class PipeSink : public ImageSink {
+public:
+	//! Frames held for a missing earlier one, beyond this write() blocks until it arrives.
+	static const std::size_t MAX_REORDER_FRAMES = 8;
+	//! Seconds write() blocks for a missing frame before repeating the previous one in its place.
+	static const double REORDER_TIMEOUT;
+
+	//! Starts the command, the frames from firstFrame on are written to it in order.
+	explicit PipeSink(const std::string &command, uint32_t firstFrame = 0);
+	~PipeSink();
+
+	void write(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied) override;
+	//! The previous frame is repeated in place of a skipped one, so that the movie keeps its timing.
+	void skip(uint32_t frame) override;
+	//! Writes the frames still waiting for a missing one and waits for the encoder to finish.
+	void close() override;
+	bool hasFailed() const override { return mFailed; }
+
+	bool isOpen() const { return mPipe != nullptr; }
+
+private:
+	//writes the frames which are ready in order, filling the gaps below upTo
+	void flush(uint32_t upTo);
+	void writeFrame(const cinder::Surface &surface);
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::FILE *mPipe = nullptr;
+	uint32_t mNextFrame;
+	//frames which arrived before the previous ones from other workers, empty for skipped ones
+	std::map<uint32_t, cinder::Surface> mReorderBuffer;
+	cinder::Surface mLastSurface;
+	std::atomic<bool> mFailed{ false };
+};
+
+/*
+* Discards the frames, for measuring rendering alone.
+*/
+class NullSink : public ImageSink {
+public:
+	bool handlesFlip() const override { return true; }
+	bool handlesUnpremultiply() const override { return true; }
+	bool handlesDuplicates() const override { return true; }
+	bool handlesCrop() const override { return true; }
+
+	void write(uint32_t frame, const std::string &path, const cinder::Surface &surface, bool flipped, bool premultiplied) override {}
+	bool writeDuplicate(uint32_t frame, const std::string &path, uint32_t sourceFrame, const std::string &sourcePath) override { return true; }
+};
+
+}
\ No newline at end of file
@@ -23,42 +23,202 @@
 */
 
 #include "ImageWriter.h"
-#include "cinder/ImageIo.h"
 #include "cinder/ip/Flip.h"
 #include "cinder/ip/Premultiply.h"
+#include <algorithm>
+#include <functional>
+#include <cstring>
 
 namespace atarabi {
 
-ImageWriter::ImageWriter() : mFlip{ false }, mUnpremultiply{ false }, mAbort { false }, mImages{ DEFAULT_BUFFER_SIZE }
+namespace {
+
+const uint64_t PRIME1 = 11400714785074694791ull;
+const uint64_t PRIME2 = 14029467366897019727ull;
+
+inline uint64_t rotl(uint64_t x, int r)
 {
-	initThread();
+	return (x << r) | (x >> (64 - r));
 }
 
-ImageWriter::ImageWriter(std::size_t buffer_size) : mFlip{ false }, mUnpremultiply{ false }, mAbort{ false }, mImages{ buffer_size }
+inline uint64_t mixLane(uint64_t lane, uint64_t value)
 {
-	initThread();
+	return rotl(lane + value * PRIME2, 31) * PRIME1;
+}
+
+//xxHash64 style rounds over four independent lanes
+uint64_t hashSurface(const cinder::Surface &surface)
+{
+	uint64_t lanes[4] = { PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1 };
+
+	std::size_t rowBytes = static_cast<std::size_t>(surface.getWidth()) * surface.getPixelInc();
+	std::size_t blocks = rowBytes / 32;
+
+	for (int32_t y = 0; y < surface.getHeight(); ++y)
+	{
+		const uint8_t *row = surface.getData() + surface.getRowBytes() * y;
+
+		for (std::size_t i = 0; i < blocks; ++i)
+		{
+			uint64_t values[4];
+			std::memcpy(values, row + i * 32, sizeof(values));
+			for (int j = 0; j < 4; ++j)
+			{
+				lanes[j] = mixLane(lanes[j], values[j]);
+			}
+		}
+
+		for (std::size_t i = blocks * 32; i < rowBytes; ++i)
+		{
+			lanes[0] = mixLane(lanes[0], row[i]);
+		}
+	}
+
+	uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+	hash ^= static_cast<uint64_t>(surface.getWidth()) << 32 | static_cast<uint32_t>(surface.getHeight());
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+
+	return hash;
+}
+
+bool equalPixels(const cinder::Surface &a, const cinder::Surface &b)
+{
+	if (a.getSize() != b.getSize() || a.getChannelOrder().getCode() != b.getChannelOrder().getCode())
+	{
+		return false;
+	}
+
+	std::size_t rowBytes = static_cast<std::size_t>(a.getWidth()) * a.getPixelInc();
+	for (int32_t y = 0; y < a.getHeight(); ++y)
+	{
+		if (std::memcmp(a.getData() + a.getRowBytes() * y, b.getData() + b.getRowBytes() * y, rowBytes) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+} //anonymous namespace
+
+ImageWriter::ImageWriter() : mImages{ DEFAULT_BUFFER_SIZE }, mSink{ std::make_shared<FileSink>() }, mPending{ 0 }, mNumDuplicates{ 0 }, mDeduplicate{ false }, mFlip{ false }, mUnpremultiply{ false }, mAbort{ false }
+{
+	initThreads(1);
+}
+
+ImageWriter::ImageWriter(std::size_t buffer_size, int numThreads) : mImages{ buffer_size }, mSink{ std::make_shared<FileSink>() }, mPending{ 0 }, mNumDuplicates{ 0 }, mDeduplicate{ false }, mFlip{ false }, mUnpremultiply{ false }, mAbort{ false }
+{
+	initThreads(numThreads);
 }
 
 ImageWriter::~ImageWriter()
 {
-	mAbort = true;
+	{
+		std::lock_guard<std::mutex> lock{ mWrittenMutex };
+		mAbort = true;
+	}
 	mImages.cancel();
-	mThread->join();
+	mWrittenCondition.notify_all();
+	for (auto &thread : mThreads)
+	{
+		thread->join();
+	}
 }
 
-void ImageWriter::pushImage(const std::string &path, const cinder::Surface &surface)
+void ImageWriter::setSink(std::shared_ptr<ImageSink> sink)
 {
-	mImages.pushFront({ path, surface });
+	mSink = sink ? sink : std::make_shared<FileSink>();
+
+	mNumDuplicates = 0;
+	mHasLast = false;
+	mLastSurface = cinder::Surface{};
+	std::lock_guard<std::mutex> lock{ mWrittenMutex };
+	mWritten.clear();
+}
+
+void ImageWriter::pushImage(const std::string &path, const cinder::Surface &surface, uint32_t frame)
+{
+	Image image{ path, surface, frame };
+	push(image);
+}
+
+void ImageWriter::pushImage(const std::string &path, const cinder::Surface &surface, uint32_t frame, const cinder::ivec2 &offset, const cinder::ivec2 &frameSize)
+{
+	Image image{ path, surface, frame, offset, frameSize };
+	push(image);
+}
+
+void ImageWriter::push(Image &image)
+{
+	const cinder::Surface &surface = image.surface();
+	uint32_t frame = image.frame();
+	const std::string &path = image.path();
+
+	//hashed here, since the frames arrive in order only on this thread
+	if (mDeduplicate && mSink->handlesDuplicates() && surface.getDataStore())
+	{
+		//the same pixels elsewhere in the frame are a change
+		uint64_t hash = hashSurface(surface);
+		hash = mixLane(hash, static_cast<uint64_t>(static_cast<uint32_t>(image.offset().x)) << 32 | static_cast<uint32_t>(image.offset().y));
+		hash = mixLane(hash, static_cast<uint64_t>(static_cast<uint32_t>(image.frameSize().x)) << 32 | static_cast<uint32_t>(image.frameSize().y));
+		//the hash only picks the candidates, a collision must not repeat a frame which changed
+		bool same = mHasLast && hash == mLastHash && image.offset() == mLastOffset && image.frameSize() == mLastFrameSize && equalPixels(surface, mLastSurface);
+		if (same)
+		{
+			image.setSource(mLastFrame, mLastPath);
+			std::lock_guard<std::mutex> lock{ mWrittenMutex };
+			++mWritten[mLastFrame].numWaiting;
+		}
+		else
+		{
+			{
+				std::lock_guard<std::mutex> lock{ mWrittenMutex };
+				//no later frame can repeat the previous one
+				auto it = mHasLast ? mWritten.find(mLastFrame) : mWritten.end();
+				if (it != mWritten.end())
+				{
+					it->second.retired = true;
+					if (it->second.done && it->second.numWaiting == 0)
+					{
+						mWritten.erase(it);
+					}
+				}
+				mWritten[frame] = Written{};
+			}
+
+			mHasLast = true;
+			mLastHash = hash;
+			mLastFrame = frame;
+			mLastPath = path;
+			mLastOffset = image.offset();
+			mLastFrameSize = image.frameSize();
+			//a copy, since the workers flip and unpremultiply the pixels in place
+			mLastSurface = surface.clone();
+		}
+	}
+
+	++mPending;
+	mImages.pushFront(image);
 }
 
 bool ImageWriter::empty()
 {
-	return !mImages.isNotEmpty();
+	return mPending == 0;
 }
 
-void ImageWriter::initThread()
+void ImageWriter::initThreads(int numThreads)
 {
-	mThread = std::make_shared<std::thread>(std::bind(&ImageWriter::writeImage, this));
+	if (numThreads <= 0)
+	{
+		numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	for (int i = 0; i < numThreads; ++i)
+	{
+		mThreads.push_back(std::make_shared<std::thread>(std::bind(&ImageWriter::writeImage, this)));
+	}
 }
 
 void ImageWriter::writeImage()
@@ -70,24 +230,49 @@ void ImageWriter::writeImage()
 		Image image;
 		mImages.popBack(&image);
 
-		cinder::fs::path path = image.path();
+		if (mAbort)
+		{
+			break;
+		}
+
 		auto &surface = image.surface();
+		bool succeeded = false;
 
-		if (surface.getDataStore())
+		//the sink is only replaced while nothing is pending
+		auto sink = mSink;
+
+		if (image.hasSource() && waitWritten(image.sourceFrame()) && sink->writeDuplicate(image.frame(), image.path(), image.sourceFrame(), image.sourcePath()))
+		{
+			++mNumDuplicates;
+			succeeded = true;
+		}
+		else if (surface.getDataStore())
 		{
 			try
 			{
-				if (mUnpremultiply)
+				bool premultiplied = mUnpremultiply;
+				if (premultiplied && !sink->handlesUnpremultiply())
 				{
 					cinder::ip::unpremultiply(&surface);
+					premultiplied = false;
 				}
 
-				if (mFlip)
+				bool flipped = mFlip;
+				if (flipped && !sink->handlesFlip())
 				{
 					cinder::ip::flipVertical( &surface );
+					flipped = false;
 				}
 
-				cinder::writeImage(path, surface);
+				if (image.isCropped() && sink->handlesCrop())
+				{
+					sink->writeCropped(image.frame(), image.path(), surface, flipped, premultiplied, image.offset(), image.frameSize());
+				}
+				else
+				{
+					sink->write(image.frame(), image.path(), surface, flipped, premultiplied);
+				}
+				succeeded = true;
 			}
 			//when window is minimized
 			catch (...)
@@ -95,6 +280,73 @@ void ImageWriter::writeImage()
 				//pass
 			}
 		}
+
+		if (image.hasSource())
+		{
+			releaseSource(image.sourceFrame());
+		}
+		else if (sink->handlesDuplicates())
+		{
+			setWritten(image.frame(), succeeded);
+		}
+
+		//sinks which keep the frames in order stop waiting for this one
+		if (!succeeded)
+		{
+			sink->skip(image.frame());
+		}
+
+		--mPending;
+	}
+}
+
+bool ImageWriter::waitWritten(uint32_t frame)
+{
+	//the source was pushed earlier, so another worker is already writing it
+	std::unique_lock<std::mutex> lock{ mWrittenMutex };
+	//the entry stays until this duplicate releases it
+	auto it = mWritten.find(frame);
+	if (it == mWritten.end())
+	{
+		return false;
+	}
+	mWrittenCondition.wait(lock, [&]() -> bool { return mAbort || it->second.done; });
+
+	return !mAbort && it->second.succeeded;
+}
+
+void ImageWriter::setWritten(uint32_t frame, bool succeeded)
+{
+	{
+		std::lock_guard<std::mutex> lock{ mWrittenMutex };
+		//frames pushed without the hash have no entry
+		auto it = mWritten.find(frame);
+		if (it == mWritten.end())
+		{
+			return;
+		}
+		it->second.done = true;
+		it->second.succeeded = succeeded;
+		if (it->second.retired && it->second.numWaiting == 0)
+		{
+			mWritten.erase(it);
+		}
+	}
+	mWrittenCondition.notify_all();
+}
+
+void ImageWriter::releaseSource(uint32_t frame)
+{
+	std::lock_guard<std::mutex> lock{ mWrittenMutex };
+	auto it = mWritten.find(frame);
+	if (it == mWritten.end())
+	{
+		return;
+	}
+	--it->second.numWaiting;
+	if (it->second.retired && it->second.done && it->second.numWaiting == 0)
+	{
+		mWritten.erase(it);
 	}
 }
 
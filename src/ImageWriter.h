@@ -27,7 +27,14 @@
 #include "cinder/Surface.h"
 #include "cinder/Thread.h"
 #include "cinder/ConcurrentCircularBuffer.h"
+#include "ImageSink.h"
 #include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <condition_variable>
 
 namespace atarabi {
 
@@ -35,36 +42,95 @@ class ImageWriter {
 	class Image {
 	public:
 		Image() {}
-		Image(const std::string &path, const cinder::Surface &surface) : mPath(path), mSurface{ surface }{}
+		Image(const std::string &path, const cinder::Surface &surface, uint32_t frame) : mPath(path), mSurface{ surface }, mFrame{ frame }, mFrameSize{ surface.getSize() }{}
+		Image(const std::string &path, const cinder::Surface &surface, uint32_t frame, const cinder::ivec2 &offset, const cinder::ivec2 &frameSize) : mPath(path), mSurface{ surface }, mFrame{ frame }, mOffset{ offset }, mFrameSize{ frameSize }{}
 
 		const std::string &path() const { return mPath; }
 		cinder::Surface &surface() { return mSurface; }
+		uint32_t frame() const { return mFrame; }
+
+		//a cropped image is the region at offset of the frame
+		bool isCropped() const { return mSurface.getSize() != mFrameSize; }
+		const cinder::ivec2 &offset() const { return mOffset; }
+		const cinder::ivec2 &frameSize() const { return mFrameSize; }
+
+		//an unchanged frame repeats the source instead of being converted and encoded again
+		void setSource(uint32_t frame, const std::string &path) { mHasSource = true; mSourceFrame = frame; mSourcePath = path; }
+		bool hasSource() const { return mHasSource; }
+		uint32_t sourceFrame() const { return mSourceFrame; }
+		const std::string &sourcePath() const { return mSourcePath; }
 
 	private:
 		std::string mPath;
 		cinder::Surface mSurface;
+		uint32_t mFrame = 0;
+		cinder::ivec2 mOffset;
+		cinder::ivec2 mFrameSize;
+		bool mHasSource = false;
+		uint32_t mSourceFrame = 0;
+		std::string mSourcePath;
 	};
 
 public:
 	static const int DEFAULT_BUFFER_SIZE = 150;
 
 	ImageWriter();
-	ImageWriter(std::size_t buffer_size);
+	//! numThreads is the number of workers(0 means the number of cores).
+	ImageWriter(std::size_t buffer_size, int numThreads = 1);
 
 	~ImageWriter();
 
 	void setFlip( bool flip ) { mFlip = flip; }
 	void setUnpremultiply(bool unpremultiply) { mUnpremultiply = unpremultiply; }
+	//! Sets where the images go(nullptr writes files), must be called while empty().
+	void setSink(std::shared_ptr<ImageSink> sink);
+
+	//! Skips converting and encoding frames identical to the previous one when the sink can repeat it(off by default).
+	//! Costs a hash of every frame on the pushing thread, and a compare and a copy of each frame which changed.
+	void setDeduplicate(bool deduplicate) { mDeduplicate = deduplicate; }
 
-	void pushImage(const std::string &path, const cinder::Surface &surface);
+	void pushImage(const std::string &path, const cinder::Surface &surface, uint32_t frame = 0);
+	//! Pushes the region at offset(top-down pixels) of a frame of frameSize, for a sink which handlesCrop().
+	void pushImage(const std::string &path, const cinder::Surface &surface, uint32_t frame, const cinder::ivec2 &offset, const cinder::ivec2 &frameSize);
+	//! Returns whether every pushed image has been written.
 	bool empty();
 
+	//! Returns the number of frames repeated since the sink was set.
+	int getNumDuplicates() const { return mNumDuplicates; }
+
 private:
-	void initThread();
+	void initThreads(int numThreads);
 	void writeImage();
+	void push(Image &image);
+	bool waitWritten(uint32_t frame);
+	void setWritten(uint32_t frame, bool succeeded);
+	void releaseSource(uint32_t frame);
 
-	std::shared_ptr<std::thread> mThread;
+	std::vector<std::shared_ptr<std::thread>> mThreads;
 	cinder::ConcurrentCircularBuffer<Image> mImages;
+	std::shared_ptr<ImageSink> mSink;
+	std::atomic<int> mPending;
+	std::atomic<int> mNumDuplicates;
+	//the last frame which was pushed with its pixels
+	bool mDeduplicate;
+	bool mHasLast = false;
+	uint64_t mLastHash = 0;
+	uint32_t mLastFrame = 0;
+	std::string mLastPath;
+	cinder::ivec2 mLastOffset;
+	cinder::ivec2 mLastFrameSize;
+	cinder::Surface mLastSurface;
+	//the frames which may still be repeated, dropped once retired and no duplicate waits for them
+	struct Written
+	{
+		bool done = false;
+		bool succeeded = false;
+		bool retired = false;
+		int numWaiting = 0;
+	};
+	std::mutex mWrittenMutex;
+	std::condition_variable mWrittenCondition;
+	std::map<uint32_t, Written> mWritten;
 	bool mFlip;
 	bool mUnpremultiply;
 	bool mAbort;
@@ -0,0 +1,147 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "MappedFile.h"
+
+#if defined(CINDER_MSW)
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace atarabi {
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#if defined(CINDER_MSW)
+
+bool MappedFile::open(const cinder::fs::path &path)
+{
+	close();
+
+	HANDLE file = ::CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		::CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		::CloseHandle(file);
+		return false;
+	}
+
+	void *data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		::CloseHandle(mapping);
+		::CloseHandle(file);
+		return false;
+	}
+
+	mFile = file;
+	mMapping = mapping;
+	mData = data;
+	mSize = static_cast<std::size_t>(size.QuadPart);
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (mData)
+	{
+		::UnmapViewOfFile(mData);
+		::CloseHandle(mMapping);
+		::CloseHandle(mFile);
+	}
+
+	mData = nullptr;
+	mMapping = nullptr;
+	mFile = nullptr;
+	mSize = 0;
+}
+
+#else
+
+bool MappedFile::open(const cinder::fs::path &path)
+{
+	close();
+
+	int fd = ::open(path.string().c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (::fstat(fd, &status) != 0 || status.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void *data = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	//the mapping keeps its own reference to the file
+	::close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	mData = data;
+	mSize = static_cast<std::size_t>(status.st_size);
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (mData)
+	{
+		::munmap(mData, mSize);
+	}
+
+	mData = nullptr;
+	mSize = 0;
+}
+
+#endif
+
+}
\ No newline at end of file
@@ -0,0 +1,270 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "MovieLoader.h"
+#include "TextureStreamer.h"
+
+#if defined(ATARABI_MOVIE_LOADER_AVAILABLE)
+	#include "cinder/qtime/QuickTimeGl.h"
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <chrono>
+#include <thread>
+
+namespace atarabi {
+
+/*
+* Decoder
+*/
+#if defined(ATARABI_MOVIE_LOADER_AVAILABLE)
+
+class MovieLoader::Decoder {
+public:
+	Decoder(const cinder::fs::path &path) : mMovie{ cinder::qtime::MovieSurface::create(path) } {}
+
+	int32_t getNumFrames() const { return mMovie->getNumFrames(); }
+	float getFps() const { return mMovie->getFramerate(); }
+
+	bool seek(int32_t index)
+	{
+		//seeking restarts from the preceding keyframe, so it is only used for jumps
+		mMovie->seekToFrame(index);
+		return waitForFrame();
+	}
+
+	bool step()
+	{
+		mMovie->stepForward();
+		return waitForFrame();
+	}
+
+	cinder::Surface getSurface()
+	{
+		auto surface = mMovie->getSurface();
+		//the decoder reuses its buffers
+		return surface ? surface->clone() : cinder::Surface{};
+	}
+
+private:
+	//qtime only hands over a frame when it is polled(on Windows checkNewFrame also runs the decoder task), so this polls with a growing interval until a deadline
+	bool waitForFrame()
+	{
+		static const int TIMEOUT_MILLISECONDS = 1000;
+		static const int MAX_INTERVAL_MILLISECONDS = 8;
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT_MILLISECONDS);
+		int interval = 0;
+
+		while (!mMovie->checkNewFrame())
+		{
+			if (std::chrono::steady_clock::now() >= deadline)
+			{
+				return false;
+			}
+
+			if (interval == 0)
+			{
+				std::this_thread::yield();
+				interval = 1;
+			}
+			else
+			{
+				//sleep granularity is coarse on Windows, the deadline keeps the timeout independent of it
+				std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+				interval = std::min(interval * 2, MAX_INTERVAL_MILLISECONDS);
+			}
+		}
+
+		return true;
+	}
+
+	cinder::qtime::MovieSurfaceRef mMovie;
+};
+
+#else
+
+class MovieLoader::Decoder {
+public:
+	Decoder(const cinder::fs::path &) {}
+
+	int32_t getNumFrames() const { return 0; }
+	float getFps() const { return 0.f; }
+	bool seek(int32_t) { return false; }
+	bool step() { return false; }
+	cinder::Surface getSurface() { return cinder::Surface{}; }
+};
+
+#endif
+
+/*
+* MovieLoader
+*/
+MovieLoader::MovieLoader() {}
+
+MovieLoader::MovieLoader(const std::string &moviePath, float startTime, float compFps)
+{
+	load(moviePath, startTime, compFps);
+}
+
+MovieLoader::~MovieLoader() {}
+
+bool MovieLoader::isMovie(const std::string &path)
+{
+	std::string extension = cinder::fs::path{ path }.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) -> char {
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	});
+
+	return extension == ".mov" || extension == ".avi" || extension == ".mp4" || extension == ".m4v";
+}
+
+void MovieLoader::load(const std::string &moviePath, float startTime, float compFps)
+{
+	reset();
+
+	mStartTime = startTime;
+	mCompFps = compFps;
+
+	if (!cinder::fs::exists(moviePath) || !cinder::fs::is_regular_file(moviePath))
+	{
+		return;
+	}
+
+	try
+	{
+		mDecoder.reset(new Decoder{ moviePath });
+		mNumFrames = std::max(0, mDecoder->getNumFrames());
+		mFps = mDecoder->getFps();
+	}
+	catch (...)
+	{
+		reset();
+	}
+}
+
+void MovieLoader::reset()
+{
+	mDecoder.reset();
+	mNumFrames = 0;
+	mFps = 0.f;
+	mStartTime = 0.f;
+	mCompFps = 0.f;
+	mCurrentIndex = -1;
+	mSurface = cinder::Surface{};
+}
+
+cinder::Surface MovieLoader::getSurface(int32_t frame)
+{
+	assert(!empty());
+
+	int32_t index = getIndex(frame);
+
+	if (index == mCurrentIndex)
+	{
+		return mSurface;
+	}
+
+	//sequential access only decodes the frames in between, any other access seeks
+	bool decoded = true;
+	int32_t distance = index - mCurrentIndex;
+	if (mCurrentIndex >= 0 && distance > 0 && distance <= MAX_STEP_FRAMES)
+	{
+		for (int32_t i = 0; i < distance && decoded; ++i)
+		{
+			decoded = mDecoder->step();
+		}
+	}
+	else
+	{
+		decoded = mDecoder->seek(index);
+	}
+
+	if (decoded)
+	{
+		mSurface = mDecoder->getSurface();
+		mCurrentIndex = index;
+	}
+	else
+	{
+		//the decoder position is unknown, seek next time
+		mCurrentIndex = -1;
+	}
+
+	return mSurface;
+}
+
+cinder::gl::TextureRef MovieLoader::getTexture(int32_t frame)
+{
+	if (!mTextureStreamer)
+	{
+		mTextureStreamer.reset(new TextureStreamer{});
+	}
+
+	cinder::Surface surface = getSurface(frame);
+	if (!surface.getData())
+	{
+		return nullptr;
+	}
+
+	return mTextureStreamer->update(surface);
+}
+
+int32_t MovieLoader::getIndex(int32_t frame) const
+{
+	int32_t numFrames = getNumFrames();
+
+	//comp frame -> comp time -> movie time -> movie frame, the rates of the comp and the movie may differ
+	double movieTime = static_cast<double>(frame) / getCompFps() - mStartTime;
+	//the epsilon keeps a time exactly on a frame boundary from rounding down to the previous frame
+	frame = static_cast<int32_t>(std::floor(movieTime * mFps + 1e-4));
+
+	if (mLoop)
+	{
+		frame %= numFrames;
+
+		if (frame < 0)
+		{
+			frame += numFrames;
+		}
+	}
+	else
+	{
+		if (frame < 0)
+		{
+			frame = 0;
+		}
+		else if (frame >= numFrames)
+		{
+			frame = numFrames - 1;
+		}
+	}
+
+	return frame;
+}
+
+}
\ No newline at end of file
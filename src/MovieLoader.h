@@ -0,0 +1,98 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Filesystem.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Surface.h"
+#include "cinder/gl/Texture.h"
+
+#include <string>
+#include <memory>
+
+#if defined(CINDER_MAC) || (defined(CINDER_MSW) && !defined(_WIN64))
+	#define ATARABI_MOVIE_LOADER_AVAILABLE
+#endif
+
+namespace atarabi {
+
+class TextureStreamer;
+
+/*
+* Decodes a movie file frame by frame with the same interface as ImageSequenceLoader.
+*/
+class MovieLoader {
+	class Decoder;
+
+public:
+	//! Steps forward instead of seeking when the requested frame is at most this far ahead, decoding every frame in between.
+	//! Longer forward jumps and any backward jump seek, and the decoder serves a seek by decoding every frame from the preceding keyframe up to the requested one.
+	//! The decoder does not expose where the keyframes are, so this is a fixed guess: a jump inside one GOP may still seek, and a step may decode more frames than a seek would.
+	static const int MAX_STEP_FRAMES = 8;
+
+	MovieLoader();
+	MovieLoader(const std::string &moviePath, float startTime = 0.f, float compFps = 0.f);
+	~MovieLoader();
+
+	MovieLoader(const MovieLoader &) = delete;
+	MovieLoader &operator=(const MovieLoader &) = delete;
+
+	//! Returns whether the path has one of the extensions of movie files.
+	static bool isMovie(const std::string &path);
+
+	//! Loads a movie whose first frame is shown at startTime(pass getSourceTime()), frames passed to getSurface() are comp frames at compFps(0 means the movie's own rate).
+	void load(const std::string &moviePath, float startTime = 0.f, float compFps = 0.f);
+	void reset();
+
+	void setLoop(bool loop) { mLoop = loop; }
+	bool isLoop() const { return mLoop; }
+	void setCompFps(float compFps) { mCompFps = compFps; }
+	float getCompFps() const { return mCompFps > 0.f ? mCompFps : mFps; }
+
+	bool empty() const { return mNumFrames == 0; }
+	int32_t getNumFrames() const { return mNumFrames; }
+	float getFps() const { return mFps; }
+	cinder::ImageSourceRef getImage(int32_t frame) { return getSurface(frame); }
+	//! Returns the decoded frame, decoding sequentially when frames are requested in order.
+	cinder::Surface getSurface(int32_t frame);
+	//! Returns the frame uploaded to one of a few reused textures through pixel buffers(must be called on the GL thread).
+	cinder::gl::TextureRef getTexture(int32_t frame);
+
+protected:
+	int32_t getIndex(int32_t frame) const;
+
+	bool mLoop = false;
+	int32_t mNumFrames = 0;
+	float mFps = 0.f;
+	float mStartTime = 0.f;
+	float mCompFps = 0.f;
+	int32_t mCurrentIndex = -1;
+	cinder::Surface mSurface;
+	std::unique_ptr<Decoder> mDecoder;
+	std::unique_ptr<TextureStreamer> mTextureStreamer;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,218 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "ParticleRenderer.h"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
+
+namespace atarabi {
+
+namespace {
+
+const GLuint POSITION_LOCATION = 0;
+const GLuint INSTANCE_POSITION_SIZE_LOCATION = 1;
+const GLuint INSTANCE_COLOR_LOCATION = 2;
+
+//the same transform as translating and scaling the model matrix per circle
+const char *VERTEX_SHADER = R"(
+#version 150
+uniform mat4 ciModelViewProjection;
+in vec2 ciPosition;
+in vec4 iPositionSize;
+in vec4 iColor;
+out vec4 vColor;
+void main()
+{
+	vColor = iColor;
+	gl_Position = ciModelViewProjection * vec4(ciPosition * iPositionSize.z + iPositionSize.xy, 0.0, 1.0);
+}
+)";
+
+const char *FRAGMENT_SHADER = R"(
+#version 150
+in vec4 vColor;
+out vec4 oColor;
+void main()
+{
+	oColor = vColor;
+}
+)";
+
+} //anonymous namespace
+
+const int ParticleRenderer::DEFAULT_SUBDIVISIONS;
+const std::size_t ParticleRenderer::MIN_CAPACITY;
+
+ParticleRenderer::ParticleRenderer(int subdivisions)
+{
+	auto version = cinder::gl::getVersion();
+	mPersistent = version.first > 4 || (version.first == 4 && version.second >= 4) || cinder::gl::isExtensionAvailable("GL_ARB_buffer_storage");
+
+	//a triangle fan around the center
+	subdivisions = std::max(3, subdivisions);
+	std::vector<cinder::vec2> vertices;
+	vertices.emplace_back(0.f, 0.f);
+	for (int i = 0; i <= subdivisions; ++i)
+	{
+		float angle = 2.f * 3.14159265358979f * i / subdivisions;
+		vertices.emplace_back(std::cos(angle), std::sin(angle));
+	}
+	mNumVertices = static_cast<GLsizei>(vertices.size());
+	mShape = cinder::gl::Vbo::create(GL_ARRAY_BUFFER, vertices, GL_STATIC_DRAW);
+
+	mShader = cinder::gl::GlslProg::create(cinder::gl::GlslProg::Format{}
+		.vertex(VERTEX_SHADER)
+		.fragment(FRAGMENT_SHADER)
+		.attribLocation("ciPosition", POSITION_LOCATION)
+		.attribLocation("iPositionSize", INSTANCE_POSITION_SIZE_LOCATION)
+		.attribLocation("iColor", INSTANCE_COLOR_LOCATION));
+}
+
+ParticleRenderer::~ParticleRenderer()
+{
+	release();
+}
+
+ParticleRenderer::Instance *ParticleRenderer::map(std::size_t count)
+{
+	if (count > mCapacity || mCapacity == 0)
+	{
+		std::size_t capacity = std::max(MIN_CAPACITY, mCapacity);
+		while (capacity < count)
+		{
+			capacity *= 2;
+		}
+		allocate(capacity);
+	}
+
+	mCurrent = (mCurrent + 1) % mBuffers.size();
+	mCount = count;
+	auto &buffer = mBuffers[mCurrent];
+
+	//the GPU may still be drawing from this buffer two frames ago
+	if (buffer.fence)
+	{
+		buffer.fence->clientWaitSync(GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		buffer.fence.reset();
+	}
+
+	if (!mPersistent)
+	{
+		cinder::gl::ScopedBuffer scopedBuffer{ GL_ARRAY_BUFFER, buffer.id };
+		buffer.data = static_cast<Instance*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, mCapacity * sizeof(Instance), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	}
+
+	return buffer.data;
+}
+
+void ParticleRenderer::draw()
+{
+	auto &buffer = mBuffers[mCurrent];
+	if (!buffer.data)
+	{
+		return;
+	}
+
+	if (!mPersistent)
+	{
+		cinder::gl::ScopedBuffer scopedBuffer{ GL_ARRAY_BUFFER, buffer.id };
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		buffer.data = nullptr;
+	}
+
+	if (mCount > 0)
+	{
+		cinder::gl::ScopedGlslProg scopedGlslProg{ mShader };
+		cinder::gl::ScopedVao scopedVao{ buffer.vao };
+		cinder::gl::setDefaultShaderVars();
+		cinder::gl::drawArraysInstanced(GL_TRIANGLE_FAN, 0, mNumVertices, static_cast<GLsizei>(mCount));
+	}
+
+	buffer.fence = cinder::gl::Sync::create();
+}
+
+void ParticleRenderer::allocate(std::size_t capacity)
+{
+	release();
+
+	mCapacity = capacity;
+	GLsizeiptr bytes = static_cast<GLsizeiptr>(capacity * sizeof(Instance));
+
+	for (auto &buffer : mBuffers)
+	{
+		glGenBuffers(1, &buffer.id);
+
+		{
+			cinder::gl::ScopedBuffer scopedBuffer{ GL_ARRAY_BUFFER, buffer.id };
+			if (mPersistent)
+			{
+				GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+				buffer.data = static_cast<Instance*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags));
+			}
+			else
+			{
+				glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+			}
+		}
+
+		buffer.vao = cinder::gl::Vao::create();
+		cinder::gl::ScopedVao scopedVao{ buffer.vao };
+
+		{
+			cinder::gl::ScopedBuffer scopedBuffer{ mShape };
+			cinder::gl::enableVertexAttribArray(POSITION_LOCATION);
+			cinder::gl::vertexAttribPointer(POSITION_LOCATION, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+		}
+
+		{
+			cinder::gl::ScopedBuffer scopedBuffer{ GL_ARRAY_BUFFER, buffer.id };
+			cinder::gl::enableVertexAttribArray(INSTANCE_POSITION_SIZE_LOCATION);
+			cinder::gl::vertexAttribPointer(INSTANCE_POSITION_SIZE_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<const GLvoid*>(offsetof(Instance, position)));
+			cinder::gl::vertexAttribDivisor(INSTANCE_POSITION_SIZE_LOCATION, 1);
+			cinder::gl::enableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+			cinder::gl::vertexAttribPointer(INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<const GLvoid*>(offsetof(Instance, color)));
+			cinder::gl::vertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1);
+		}
+	}
+}
+
+void ParticleRenderer::release()
+{
+	for (auto &buffer : mBuffers)
+	{
+		if (buffer.id)
+		{
+			//deleting a buffer unmaps it
+			glDeleteBuffers(1, &buffer.id);
+		}
+		buffer = Buffer{};
+	}
+	mCapacity = 0;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "cinder/gl/gl.h"
+#include "cinder/Vector.h"
+#include "cinder/Color.h"
+
+#include <array>
+
+namespace atarabi {
+
+/*
+* Draws many circles in a single instanced call, feeding their positions, sizes and colors through double-buffered instance buffers.
+*/
+class ParticleRenderer {
+public:
+	static const int DEFAULT_SUBDIVISIONS = 60;
+	static const std::size_t MIN_CAPACITY = 1024;
+
+	struct Instance {
+		cinder::vec2 position;
+		float size;
+		float reserved;
+		cinder::ColorA color;
+	};
+
+	//! subdivisions is the number of segments of a circle(must be called on the GL thread).
+	explicit ParticleRenderer(int subdivisions = DEFAULT_SUBDIVISIONS);
+	~ParticleRenderer();
+
+	ParticleRenderer(const ParticleRenderer &) = delete;
+	ParticleRenderer &operator=(const ParticleRenderer &) = delete;
+
+	//! Returns room for count instances in the buffer the GPU has finished reading, to be filled before draw().
+	Instance *map(std::size_t count);
+	//! Draws the mapped instances as circles of radius size around position with the current matrices.
+	void draw();
+
+	//! Returns whether the buffers stay mapped(GL 4.4 or ARB_buffer_storage), otherwise they are mapped every frame.
+	bool isPersistent() const { return mPersistent; }
+
+private:
+	struct Buffer {
+		GLuint id = 0;
+		cinder::gl::VaoRef vao;
+		cinder::gl::SyncRef fence;
+		Instance *data = nullptr;
+	};
+
+	void allocate(std::size_t capacity);
+	void release();
+
+	bool mPersistent;
+	GLsizei mNumVertices;
+	cinder::gl::VboRef mShape;
+	cinder::gl::GlslProgRef mShader;
+	std::array<Buffer, 2> mBuffers;
+	std::size_t mCapacity = 0;
+	std::size_t mCurrent = 0;
+	std::size_t mCount = 0;
+};
+
+}
\ No newline at end of file
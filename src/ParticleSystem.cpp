@@ -0,0 +1,289 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace atarabi {
+
+const std::size_t ParticleSystem::MIN_CHUNK_SIZE;
+
+class ParticleSystem::Workers {
+public:
+	explicit Workers(int numThreads);
+	~Workers();
+
+	//! Runs task(0) to task(numTasks - 1) on the workers and the calling thread, returning once all of them have finished.
+	void run(std::size_t numTasks, const std::function<void(std::size_t)> &task);
+
+private:
+	void work();
+	//takes the next task with the lock held, then runs it without
+	void runNext(std::unique_lock<std::mutex> &lock);
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::condition_variable mDoneCondition;
+	const std::function<void(std::size_t)> *mTask = nullptr;
+	std::size_t mNumTasks = 0;
+	std::size_t mNext = 0;
+	std::size_t mNumDone = 0;
+	bool mAbort = false;
+	std::vector<std::thread> mThreads;
+};
+
+ParticleSystem::Workers::Workers(int numThreads)
+{
+	for (int i = 0; i < numThreads; ++i)
+	{
+		mThreads.emplace_back(std::bind(&Workers::work, this));
+	}
+}
+
+ParticleSystem::Workers::~Workers()
+{
+	{
+		std::lock_guard<std::mutex> lock{ mMutex };
+		mAbort = true;
+	}
+	mCondition.notify_all();
+
+	for (auto &thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+void ParticleSystem::Workers::run(std::size_t numTasks, const std::function<void(std::size_t)> &task)
+{
+	std::unique_lock<std::mutex> lock{ mMutex };
+	mTask = &task;
+	mNumTasks = numTasks;
+	mNext = 0;
+	mNumDone = 0;
+	mCondition.notify_all();
+
+	while (mNext < mNumTasks)
+	{
+		runNext(lock);
+	}
+
+	mDoneCondition.wait(lock, [&]() -> bool { return mNumDone == mNumTasks; });
+	mTask = nullptr;
+}
+
+void ParticleSystem::Workers::work()
+{
+	std::unique_lock<std::mutex> lock{ mMutex };
+
+	while (true)
+	{
+		mCondition.wait(lock, [&]() -> bool { return mAbort || (mTask && mNext < mNumTasks); });
+		if (mAbort)
+		{
+			break;
+		}
+
+		runNext(lock);
+	}
+}
+
+void ParticleSystem::Workers::runNext(std::unique_lock<std::mutex> &lock)
+{
+	std::size_t index = mNext++;
+	auto &task = *mTask;
+
+	lock.unlock();
+	task(index);
+	lock.lock();
+
+	if (++mNumDone == mNumTasks)
+	{
+		mDoneCondition.notify_all();
+	}
+}
+
+ParticleSystem::Field ParticleSystem::perlinField(const cinder::Perlin &perlin, float z, float intensity)
+{
+	return [perlin, z, intensity](const float *x, const float *y, std::size_t count, float *ax, float *ay) -> void {
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			cinder::vec3 deriv = perlin.dfBm(cinder::vec3{ x[i], y[i], z });
+			ax[i] = deriv.x * intensity;
+			ay[i] = deriv.y * intensity;
+		}
+	};
+}
+
+ParticleSystem::ParticleSystem(int numThreads)
+{
+	setNumThreads(numThreads);
+}
+
+ParticleSystem::~ParticleSystem()
+{
+}
+
+void ParticleSystem::setNumThreads(int numThreads)
+{
+	mNumThreads = numThreads > 0 ? numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	mWorkers.reset();
+	if (mNumThreads > 1)
+	{
+		mWorkers.reset(new Workers{ mNumThreads - 1 });
+	}
+}
+
+void ParticleSystem::reserve(std::size_t size)
+{
+	mBirths.reserve(size);
+	mLives.reserve(size);
+	mPositionsX.reserve(size);
+	mPositionsY.reserve(size);
+	mVelocitiesX.reserve(size);
+	mVelocitiesY.reserve(size);
+	mColors.reserve(size);
+	mSizes.reserve(size);
+}
+
+void ParticleSystem::clear()
+{
+	mBirths.clear();
+	mLives.clear();
+	mPositionsX.clear();
+	mPositionsY.clear();
+	mVelocitiesX.clear();
+	mVelocitiesY.clear();
+	mColors.clear();
+	mSizes.clear();
+}
+
+void ParticleSystem::emit(float birth, float life, const cinder::vec2 &position, const cinder::vec2 &velocity, const cinder::Color &color, float size)
+{
+	mBirths.push_back(birth);
+	mLives.push_back(life);
+	mPositionsX.push_back(position.x);
+	mPositionsY.push_back(position.y);
+	mVelocitiesX.push_back(velocity.x);
+	mVelocitiesY.push_back(velocity.y);
+	mColors.push_back(color);
+	mSizes.push_back(size);
+}
+
+void ParticleSystem::update(float time, const Field &field)
+{
+	removeDead(time);
+
+	std::size_t size = this->size();
+	mAccelerationsX.resize(size);
+	mAccelerationsY.resize(size);
+
+	std::size_t numChunks = std::min(static_cast<std::size_t>(mNumThreads), (size + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE);
+	if (numChunks <= 1)
+	{
+		move(0, size, field);
+		return;
+	}
+
+	std::size_t chunkSize = (size + numChunks - 1) / numChunks;
+	numChunks = (size + chunkSize - 1) / chunkSize;
+	mWorkers->run(numChunks, [&](std::size_t chunk) -> void {
+		std::size_t first = chunk * chunkSize;
+		move(first, std::min(size, first + chunkSize), field);
+	});
+}
+
+void ParticleSystem::removeDead(float time)
+{
+	std::size_t size = this->size();
+
+	for (std::size_t i = 0; i < size;)
+	{
+		if (time < mBirths[i] + mLives[i])
+		{
+			++i;
+			continue;
+		}
+
+		//the order is not kept, which makes removing O(1)
+		--size;
+		mBirths[i] = mBirths[size];
+		mLives[i] = mLives[size];
+		mPositionsX[i] = mPositionsX[size];
+		mPositionsY[i] = mPositionsY[size];
+		mVelocitiesX[i] = mVelocitiesX[size];
+		mVelocitiesY[i] = mVelocitiesY[size];
+		mColors[i] = mColors[size];
+		mSizes[i] = mSizes[size];
+	}
+
+	mBirths.resize(size);
+	mLives.resize(size);
+	mPositionsX.resize(size);
+	mPositionsY.resize(size);
+	mVelocitiesX.resize(size);
+	mVelocitiesY.resize(size);
+	mColors.resize(size);
+	mSizes.resize(size);
+}
+
+void ParticleSystem::move(std::size_t first, std::size_t last, const Field &field)
+{
+	std::size_t count = last - first;
+
+	float *x = mPositionsX.data() + first;
+	float *y = mPositionsY.data() + first;
+	float *vx = mVelocitiesX.data() + first;
+	float *vy = mVelocitiesY.data() + first;
+	float *ax = mAccelerationsX.data() + first;
+	float *ay = mAccelerationsY.data() + first;
+
+	if (field)
+	{
+		field(x, y, count, ax, ay);
+	}
+	else
+	{
+		std::fill(ax, ax + count, 0.f);
+		std::fill(ay, ay + count, 0.f);
+	}
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		vx[i] += ax[i];
+		vy[i] += ay[i];
+	}
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		x[i] += vx[i];
+		y[i] += vy[i];
+	}
+}
+
+}
\ No newline at end of file
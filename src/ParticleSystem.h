@@ -0,0 +1,98 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "cinder/Vector.h"
+#include "cinder/Color.h"
+#include "cinder/Perlin.h"
+
+#include <vector>
+#include <functional>
+#include <memory>
+
+namespace atarabi {
+
+/*
+* 2D particles stored per component, moved by an acceleration field on several threads.
+*/
+class ParticleSystem {
+public:
+	static const std::size_t MIN_CHUNK_SIZE = 4096;
+
+	//! Writes the accelerations at count positions, called once per chunk of particles instead of once per particle.
+	using Field = std::function<void(const float *x, const float *y, std::size_t count, float *ax, float *ay)>;
+
+	//! Returns a field following the derivative of perlin's fBm in the plane z, scaled by intensity.
+	//! It calls the scalar Perlin::dfBm once per particle, which dominates update(), so it only gains from the threads.
+	static Field perlinField(const cinder::Perlin &perlin, float z, float intensity);
+
+	//! numThreads is the number of threads to update on(0 means the number of cores).
+	explicit ParticleSystem(int numThreads = 0);
+	~ParticleSystem();
+
+	void setNumThreads(int numThreads);
+	int getNumThreads() const { return mNumThreads; }
+
+	void reserve(std::size_t size);
+	void clear();
+	std::size_t size() const { return mBirths.size(); }
+	bool empty() const { return mBirths.empty(); }
+
+	void emit(float birth, float life, const cinder::vec2 &position, const cinder::vec2 &velocity, const cinder::Color &color, float size);
+
+	//! Removes the particles which have died by time, swapping the last ones into their places, then adds field to the velocities of the others and moves them.
+	void update(float time, const Field &field);
+
+	const std::vector<float> &getBirths() const { return mBirths; }
+	const std::vector<float> &getLives() const { return mLives; }
+	const std::vector<float> &getPositionsX() const { return mPositionsX; }
+	const std::vector<float> &getPositionsY() const { return mPositionsY; }
+	const std::vector<float> &getVelocitiesX() const { return mVelocitiesX; }
+	const std::vector<float> &getVelocitiesY() const { return mVelocitiesY; }
+	const std::vector<cinder::Color> &getColors() const { return mColors; }
+	const std::vector<float> &getSizes() const { return mSizes; }
+
+private:
+	class Workers;
+
+	void removeDead(float time);
+	void move(std::size_t first, std::size_t last, const Field &field);
+
+	int mNumThreads;
+	//started once, the calling thread takes the first chunk
+	std::unique_ptr<Workers> mWorkers;
+
+	std::vector<float> mBirths;
+	std::vector<float> mLives;
+	std::vector<float> mPositionsX, mPositionsY;
+	std::vector<float> mVelocitiesX, mVelocitiesY;
+	std::vector<cinder::Color> mColors;
+	std::vector<float> mSizes;
+
+	//scratch for the field
+	std::vector<float> mAccelerationsX, mAccelerationsY;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,223 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "RenderTarget.h"
+#include "cinder/ip/Flip.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace atarabi {
+
+namespace {
+
+const char *VERTEX_SHADER = R"(
+#version 150
+uniform mat4 ciModelViewProjection;
+in vec4 ciPosition;
+void main()
+{
+	gl_Position = ciModelViewProjection * ciPosition;
+}
+)";
+
+//averages the factor x factor texels under each output pixel
+const char *BOX_FRAGMENT_SHADER = R"(
+#version 150
+uniform sampler2D uTexture;
+uniform int uFactor;
+out vec4 oColor;
+void main()
+{
+	ivec2 origin = ivec2(gl_FragCoord.xy) * uFactor;
+	vec4 sum = vec4(0.0);
+	for (int y = 0; y < uFactor; ++y)
+	{
+		for (int x = 0; x < uFactor; ++x)
+		{
+			sum += texelFetch(uTexture, origin + ivec2(x, y), 0);
+		}
+	}
+	oColor = sum / float(uFactor * uFactor);
+}
+)";
+
+//a 2-lobe lanczos window measured in output pixels, sharper than the box at the same factor
+const char *LANCZOS_FRAGMENT_SHADER = R"(
+#version 150
+uniform sampler2D uTexture;
+uniform int uFactor;
+out vec4 oColor;
+const float PI = 3.14159265358979;
+float lanczos2(float x)
+{
+	if (abs(x) < 1e-4)
+	{
+		return 1.0;
+	}
+	if (abs(x) >= 2.0)
+	{
+		return 0.0;
+	}
+	float px = PI * x;
+	return 2.0 * sin(px) * sin(px * 0.5) / (px * px);
+}
+void main()
+{
+	ivec2 last = textureSize(uTexture, 0) - 1;
+	vec2 center = gl_FragCoord.xy * float(uFactor);
+	int radius = 2 * uFactor;
+	ivec2 first = ivec2(floor(center)) - radius;
+	vec4 sum = vec4(0.0);
+	float weightSum = 0.0;
+	for (int y = 0; y < 2 * radius; ++y)
+	{
+		int sy = first.y + y;
+		float wy = lanczos2((float(sy) + 0.5 - center.y) / float(uFactor));
+		for (int x = 0; x < 2 * radius; ++x)
+		{
+			int sx = first.x + x;
+			float weight = wy * lanczos2((float(sx) + 0.5 - center.x) / float(uFactor));
+			sum += texelFetch(uTexture, clamp(ivec2(sx, sy), ivec2(0), last), 0) * weight;
+			weightSum += weight;
+		}
+	}
+	oColor = clamp(sum / weightSum, 0.0, 1.0);
+}
+)";
+
+int getMaxSize()
+{
+	GLint maxTextureSize = 0, maxRenderbufferSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxRenderbufferSize);
+	return std::min(maxTextureSize, maxRenderbufferSize);
+}
+
+} //anonymous namespace
+
+RenderTarget::RenderTarget(const cinder::ivec2 &size, int samples, int factor, Filter filter) : mSize{ size }, mFilter{ filter }
+{
+	mSamples = std::max(0, std::min(samples, getMaxSamples()));
+
+	//the render fbo has to fit in a texture
+	int maxFactor = std::max(1, getMaxSize() / std::max(1, std::max(size.x, size.y)));
+	mFactor = std::max(1, std::min(factor, maxFactor));
+
+	mRenderFbo = cinder::gl::Fbo::create(size.x * mFactor, size.y * mFactor, cinder::gl::Fbo::Format{}.samples(mSamples));
+
+	if (isSupersampled())
+	{
+		mOutputFbo = cinder::gl::Fbo::create(size.x, size.y, cinder::gl::Fbo::Format{}.disableDepth());
+		mShader = cinder::gl::GlslProg::create(cinder::gl::GlslProg::Format{}
+			.vertex(VERTEX_SHADER)
+			.fragment(mFilter == Filter::Lanczos ? LANCZOS_FRAGMENT_SHADER : BOX_FRAGMENT_SHADER));
+	}
+	else
+	{
+		mOutputFbo = mRenderFbo;
+	}
+
+	//the pixels outside a region of interest are never drawn
+	cinder::gl::FboRef fbos[] = { mRenderFbo, mOutputFbo };
+	for (auto &fbo : fbos)
+	{
+		cinder::gl::ScopedFramebuffer scopedFramebuffer{ fbo };
+		cinder::gl::clear(cinder::ColorA{ 0.f, 0.f, 0.f, 0.f });
+	}
+}
+
+int RenderTarget::getMaxSamples()
+{
+	GLint maxSamples = 0;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	return maxSamples;
+}
+
+RenderTarget::Filter RenderTarget::parseFilter(const std::string &name)
+{
+	return name == "lanczos" ? Filter::Lanczos : Filter::Box;
+}
+
+void RenderTarget::resolve()
+{
+	resolve(cinder::Area{ 0, 0, mSize.x, mSize.y });
+}
+
+void RenderTarget::resolve(const cinder::Area &area)
+{
+	if (!isSupersampled())
+	{
+		return;
+	}
+
+	cinder::gl::ScopedFramebuffer scopedFramebuffer{ mOutputFbo };
+	cinder::gl::ScopedViewport scopedViewport{ cinder::ivec2{ 0, 0 }, mSize };
+	cinder::gl::ScopedScissor scopedScissor{ cinder::ivec2{ area.x1, mSize.y - area.y2 }, area.getSize() };
+	cinder::gl::ScopedMatrices scopedMatrices;
+	cinder::gl::setMatricesWindow(mSize);
+	cinder::gl::ScopedDepth scopedDepth{ false };
+	cinder::gl::ScopedBlend scopedBlend{ false };
+	cinder::gl::ScopedGlslProg scopedGlslProg{ mShader };
+	//the color texture resolves the samples first
+	cinder::gl::ScopedTextureBind scopedTextureBind{ mRenderFbo->getColorTexture(), 0 };
+	mShader->uniform("uTexture", 0);
+	mShader->uniform("uFactor", mFactor);
+	cinder::gl::drawSolidRect(cinder::Rectf{ 0.f, 0.f, static_cast<float>(mSize.x), static_cast<float>(mSize.y) });
+}
+
+std::pair<cinder::ivec2, cinder::ivec2> RenderTarget::getRenderScissor(const cinder::Area &area) const
+{
+	return std::make_pair(cinder::ivec2{ area.x1, mSize.y - area.y2 } * mFactor, area.getSize() * mFactor);
+}
+
+cinder::Surface RenderTarget::readPixels(const cinder::Area &area) const
+{
+	//reads the texture the samples are resolved into
+	mOutputFbo->resolveTextures();
+	cinder::gl::ScopedFramebuffer scopedFramebuffer{ GL_READ_FRAMEBUFFER, mOutputFbo->getId() };
+
+	cinder::Surface surface{ area.getWidth(), area.getHeight(), true };
+	GLint oldPackAlignment;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &oldPackAlignment);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(area.x1, mSize.y - area.y2, area.getWidth(), area.getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, surface.getData());
+	glPixelStorei(GL_PACK_ALIGNMENT, oldPackAlignment);
+
+	cinder::ip::flipVertical(&surface);
+	return surface;
+}
+
+std::string RenderTarget::getDescription() const
+{
+	std::stringstream ss;
+	ss << mSamples << "x msaa";
+	if (isSupersampled())
+	{
+		ss << ", " << mFactor << "x " << (mFilter == Filter::Lanczos ? "lanczos" : "box") << " supersampling";
+	}
+	return ss.str();
+}
+
+}
@@ -0,0 +1,94 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Fbo.h"
+#include "cinder/Vector.h"
+#include "cinder/Area.h"
+#include "cinder/Surface.h"
+
+#include <string>
+#include <utility>
+
+namespace atarabi {
+
+/*
+* The fbo AppAE renders into, multisampled and optionally supersampled, then filtered down to the output size.
+*/
+class RenderTarget {
+public:
+	enum class Filter {
+		Box,
+		Lanczos
+	};
+
+	//! Renders at size * factor with samples per pixel, both clamped to what the GL supports(must be called on the GL thread).
+	RenderTarget(const cinder::ivec2 &size, int samples, int factor = 1, Filter filter = Filter::Box);
+
+	RenderTarget(const RenderTarget &) = delete;
+	RenderTarget &operator=(const RenderTarget &) = delete;
+
+	//! Returns GL_MAX_SAMPLES.
+	static int getMaxSamples();
+	//! Returns the filter named "box" or "lanczos"(anything else is box).
+	static Filter parseFilter(const std::string &name);
+
+	//! The fbo to draw into, factor times larger than the output.
+	const cinder::gl::FboRef &getRenderFbo() const { return mRenderFbo; }
+	//! The fbo holding the output after resolve(), the same as the render fbo without supersampling.
+	const cinder::gl::FboRef &getOutputFbo() const { return mOutputFbo; }
+
+	cinder::ivec2 getSize() const { return mSize; }
+	int getSamples() const { return mSamples; }
+	int getFactor() const { return mFactor; }
+	Filter getFilter() const { return mFilter; }
+	bool isSupersampled() const { return mFactor > 1; }
+
+	//! Filters the render fbo down into the output fbo, nothing to do without supersampling.
+	void resolve();
+	//! Filters only the area(top-down output pixels).
+	void resolve(const cinder::Area &area);
+
+	//! Returns the lower-left corner and size of the area(top-down output pixels) in the render fbo, for scissoring.
+	std::pair<cinder::ivec2, cinder::ivec2> getRenderScissor(const cinder::Area &area) const;
+	//! Reads the area(top-down output pixels) of the output back, top-down.
+	cinder::Surface readPixels(const cinder::Area &area) const;
+
+	//! Describes the settings, e.g. "8x msaa, 2x lanczos supersampling".
+	std::string getDescription() const;
+
+private:
+	cinder::ivec2 mSize;
+	int mSamples;
+	int mFactor;
+	Filter mFilter;
+	cinder::gl::FboRef mRenderFbo;
+	cinder::gl::FboRef mOutputFbo;
+	cinder::gl::GlslProgRef mShader;
+};
+
+}
@@ -0,0 +1,203 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "SharedMemory.h"
+
+#if defined(CINDER_MSW)
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace atarabi {
+
+SharedMemory::~SharedMemory()
+{
+	close();
+}
+
+#if defined(CINDER_MSW)
+
+bool SharedMemory::create(const std::string &name, std::size_t size)
+{
+	close();
+
+	uint64_t size64 = size;
+	HANDLE mapping = ::CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFF), name.c_str());
+	if (!mapping)
+	{
+		return false;
+	}
+
+	void *data = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!data)
+	{
+		::CloseHandle(mapping);
+		return false;
+	}
+
+	mMapping = mapping;
+	mData = data;
+	mSize = size;
+	mName = name;
+
+	return true;
+}
+
+bool SharedMemory::open(const std::string &name)
+{
+	close();
+
+	HANDLE mapping = ::OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+	if (!mapping)
+	{
+		return false;
+	}
+
+	void *data = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (!data)
+	{
+		::CloseHandle(mapping);
+		return false;
+	}
+
+	MEMORY_BASIC_INFORMATION info;
+	::VirtualQuery(data, &info, sizeof(info));
+
+	mMapping = mapping;
+	mData = data;
+	mSize = info.RegionSize;
+	mName = name;
+
+	return true;
+}
+
+void SharedMemory::close()
+{
+	if (mData)
+	{
+		::UnmapViewOfFile(mData);
+		::CloseHandle(mMapping);
+	}
+
+	mData = nullptr;
+	mMapping = nullptr;
+	mSize = 0;
+	mName.clear();
+}
+
+#else
+
+bool SharedMemory::create(const std::string &name, std::size_t size)
+{
+	close();
+
+	std::string path = "/" + name;
+	int fd = ::shm_open(path.c_str(), O_CREAT | O_RDWR, 0600);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (::fstat(fd, &status) != 0 || (static_cast<std::size_t>(status.st_size) < size && ::ftruncate(fd, size) != 0))
+	{
+		::close(fd);
+		return false;
+	}
+
+	void *data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	mData = data;
+	mSize = size;
+	mName = name;
+	mOwner = true;
+
+	return true;
+}
+
+bool SharedMemory::open(const std::string &name)
+{
+	close();
+
+	std::string path = "/" + name;
+	int fd = ::shm_open(path.c_str(), O_RDWR, 0600);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (::fstat(fd, &status) != 0 || status.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void *data = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	mData = data;
+	mSize = static_cast<std::size_t>(status.st_size);
+	mName = name;
+
+	return true;
+}
+
+void SharedMemory::close()
+{
+	if (mData)
+	{
+		::munmap(mData, mSize);
+
+		//the name outlives the processes unless its creator removes it
+		if (mOwner)
+		{
+			::shm_unlink(("/" + mName).c_str());
+		}
+	}
+
+	mData = nullptr;
+	mSize = 0;
+	mName.clear();
+	mOwner = false;
+}
+
+#endif
+
+}
\ No newline at end of file
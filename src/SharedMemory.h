@@ -0,0 +1,65 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+
+#include <string>
+#include <cstdint>
+
+namespace atarabi {
+
+/*
+* Named memory shared between processes.
+*/
+class SharedMemory {
+public:
+	SharedMemory() {}
+	~SharedMemory();
+
+	SharedMemory(const SharedMemory &) = delete;
+	SharedMemory &operator=(const SharedMemory &) = delete;
+
+	//! Creates the named memory, or opens it when it already exists with at least size bytes.
+	bool create(const std::string &name, std::size_t size);
+	//! Opens the named memory created by another process.
+	bool open(const std::string &name);
+	void close();
+
+	bool isOpen() const { return mData != nullptr; }
+	uint8_t *getData() const { return static_cast<uint8_t*>(mData); }
+	std::size_t getSize() const { return mSize; }
+
+private:
+	void *mData = nullptr;
+	std::size_t mSize = 0;
+	std::string mName;
+	bool mOwner = false;
+#if defined(CINDER_MSW)
+	void *mMapping = nullptr;
+#endif
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace atarabi {
+
+const std::size_t SpatialGrid::MIN_CHUNK_SIZE;
+
+SpatialGrid::SpatialGrid(float cellSize, int numThreads) : mCellSize{ cellSize }
+{
+	setNumThreads(numThreads);
+}
+
+void SpatialGrid::setNumThreads(int numThreads)
+{
+	mNumThreads = numThreads > 0 ? numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+template<class Function>
+void SpatialGrid::parallelFor(std::size_t size, Function function)
+{
+	std::size_t numChunks = mOffsets.size();
+	std::size_t chunkSize = (size + numChunks - 1) / numChunks;
+
+	std::vector<std::thread> threads;
+	for (std::size_t chunk = 1; chunk < numChunks; ++chunk)
+	{
+		threads.emplace_back(function, chunk, chunk * chunkSize, std::min(size, (chunk + 1) * chunkSize));
+	}
+
+	function(0, 0, std::min(size, chunkSize));
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+void SpatialGrid::build(const float *x, const float *y, std::size_t count)
+{
+	//about one point per bucket
+	uint32_t numBuckets = 1;
+	while (numBuckets < count)
+	{
+		numBuckets <<= 1;
+	}
+	mMask = numBuckets - 1;
+
+	std::size_t numChunks = std::max<std::size_t>(1, std::min(static_cast<std::size_t>(mNumThreads), (count + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE));
+	mOffsets.resize(numChunks);
+
+	mBuckets.resize(count);
+	mCells.resize(count);
+	mIndices.resize(count);
+	mSortedCells.resize(count);
+	mSortedX.resize(count);
+	mSortedY.resize(count);
+
+	//count the points of each bucket per chunk
+	parallelFor(count, [&](std::size_t chunk, std::size_t first, std::size_t last) -> void {
+		auto &histogram = mOffsets[chunk];
+		histogram.assign(numBuckets, 0);
+
+		for (std::size_t i = first; i < last; ++i)
+		{
+			int32_t cx = getCell(x[i]);
+			int32_t cy = getCell(y[i]);
+			uint32_t bucket = hashCell(cx, cy);
+			mBuckets[i] = bucket;
+			mCells[i] = packCell(cx, cy);
+			++histogram[bucket];
+		}
+	});
+
+	//bucket by bucket, each chunk writes after the previous chunks
+	mBucketStarts.resize(numBuckets + 1);
+	uint32_t offset = 0;
+	for (uint32_t bucket = 0; bucket < numBuckets; ++bucket)
+	{
+		mBucketStarts[bucket] = offset;
+		for (auto &histogram : mOffsets)
+		{
+			uint32_t number = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += number;
+		}
+	}
+	mBucketStarts[numBuckets] = offset;
+
+	//scatter, which keeps the input order within a bucket
+	parallelFor(count, [&](std::size_t chunk, std::size_t first, std::size_t last) -> void {
+		auto &offsets = mOffsets[chunk];
+
+		for (std::size_t i = first; i < last; ++i)
+		{
+			uint32_t j = offsets[mBuckets[i]]++;
+			mIndices[j] = static_cast<uint32_t>(i);
+			mSortedCells[j] = mCells[i];
+			mSortedX[j] = x[i];
+			mSortedY[j] = y[i];
+		}
+	});
+}
+
+}
\ No newline at end of file
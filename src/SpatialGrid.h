@@ -0,0 +1,116 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+namespace atarabi {
+
+/*
+* A uniform grid over 2D points for neighbor queries, hashed into a table and built by counting sort, so that the points of a cell are contiguous.
+*/
+class SpatialGrid {
+public:
+	static const std::size_t MIN_CHUNK_SIZE = 4096;
+
+	//! cellSize should be about the query radius, numThreads is the number of threads to build on(0 means the number of cores).
+	explicit SpatialGrid(float cellSize, int numThreads = 0);
+
+	void setCellSize(float cellSize) { mCellSize = cellSize; }
+	float getCellSize() const { return mCellSize; }
+	void setNumThreads(int numThreads);
+
+	//! Sorts the count points into their cells, e.g. ParticleSystem's positions once per frame.
+	void build(const float *x, const float *y, std::size_t count);
+
+	std::size_t size() const { return mIndices.size(); }
+
+	//! Calls visit(index, distanceSquared) for every point within radius of (x, y), where index is the position in the arrays passed to build().
+	template<class Visitor>
+	void query(float x, float y, float radius, Visitor visit) const
+	{
+		if (mIndices.empty())
+		{
+			return;
+		}
+
+		float radiusSquared = radius * radius;
+		int32_t minX = getCell(x - radius), maxX = getCell(x + radius);
+		int32_t minY = getCell(y - radius), maxY = getCell(y + radius);
+
+		for (int32_t cy = minY; cy <= maxY; ++cy)
+		{
+			for (int32_t cx = minX; cx <= maxX; ++cx)
+			{
+				uint64_t cell = packCell(cx, cy);
+				uint32_t bucket = hashCell(cx, cy);
+
+				for (uint32_t i = mBucketStarts[bucket], end = mBucketStarts[bucket + 1]; i < end; ++i)
+				{
+					//other cells may share the bucket
+					if (mSortedCells[i] != cell)
+					{
+						continue;
+					}
+
+					float dx = mSortedX[i] - x;
+					float dy = mSortedY[i] - y;
+					float distanceSquared = dx * dx + dy * dy;
+					if (distanceSquared <= radiusSquared)
+					{
+						visit(mIndices[i], distanceSquared);
+					}
+				}
+			}
+		}
+	}
+
+private:
+	int32_t getCell(float value) const { return static_cast<int32_t>(std::floor(value / mCellSize)); }
+	static uint64_t packCell(int32_t cx, int32_t cy) { return static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32 | static_cast<uint32_t>(cy); }
+	uint32_t hashCell(int32_t cx, int32_t cy) const { return (static_cast<uint32_t>(cx) * 73856093u ^ static_cast<uint32_t>(cy) * 19349663u) & mMask; }
+
+	template<class Function>
+	void parallelFor(std::size_t size, Function function);
+
+	float mCellSize;
+	int mNumThreads;
+	uint32_t mMask = 0;
+
+	//the bucket of every point in input order
+	std::vector<uint32_t> mBuckets;
+	std::vector<uint64_t> mCells;
+	//a histogram per chunk, turned into where each chunk writes
+	std::vector<std::vector<uint32_t>> mOffsets;
+
+	std::vector<uint32_t> mBucketStarts;
+	std::vector<uint32_t> mIndices;
+	std::vector<uint64_t> mSortedCells;
+	std::vector<float> mSortedX, mSortedY;
+};
+
+}
\ No newline at end of file
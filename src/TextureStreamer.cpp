@@ -0,0 +1,148 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace atarabi {
+
+namespace {
+
+bool getPixelFormat(const cinder::SurfaceChannelOrder &channelOrder, GLenum *format)
+{
+	switch (channelOrder.getCode())
+	{
+		case cinder::SurfaceChannelOrder::RGBA:
+		case cinder::SurfaceChannelOrder::RGBX:
+			*format = GL_RGBA;
+			return true;
+		case cinder::SurfaceChannelOrder::BGRA:
+		case cinder::SurfaceChannelOrder::BGRX:
+			*format = GL_BGRA;
+			return true;
+		case cinder::SurfaceChannelOrder::RGB:
+			*format = GL_RGB;
+			return true;
+		case cinder::SurfaceChannelOrder::BGR:
+			*format = GL_BGR;
+			return true;
+	}
+
+	return false;
+}
+
+} //anonymous namespace
+
+TextureStreamer::TextureStreamer(int ringSize) : mSlots(std::max(2, ringSize)) {}
+
+cinder::gl::TextureRef TextureStreamer::update(const cinder::Surface &surface)
+{
+	GLenum format;
+	if (!getPixelFormat(surface.getChannelOrder(), &format))
+	{
+		//unusual layouts are converted once on the CPU
+		cinder::Surface converted{ surface.getWidth(), surface.getHeight(), surface.hasAlpha(), cinder::SurfaceChannelOrder::RGBA };
+		converted.copyFrom(surface, surface.getBounds());
+		return update(converted);
+	}
+
+	if (surface.getSize() != mSize || surface.getPixelInc() != mPixelInc || !mSlots[0].texture)
+	{
+		allocate(surface.getSize(), surface.getPixelInc(), surface.hasAlpha());
+	}
+
+	mCurrent = (mCurrent + 1) % mSlots.size();
+	auto &slot = mSlots[mCurrent];
+
+	//the pixel buffer may still be feeding the upload from a full ring ago
+	if (slot.fence)
+	{
+		slot.fence->clientWaitSync(GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		slot.fence.reset();
+	}
+
+	std::size_t rowBytes = static_cast<std::size_t>(surface.getWidth()) * surface.getPixelInc();
+	std::size_t bytes = rowBytes * surface.getHeight();
+
+	auto data = static_cast<uint8_t*>(slot.pbo->mapBufferRange(0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if (!data)
+	{
+		slot.texture->update(surface);
+		return slot.texture;
+	}
+
+	if (static_cast<std::size_t>(surface.getRowBytes()) == rowBytes)
+	{
+		std::memcpy(data, surface.getData(), bytes);
+	}
+	else
+	{
+		for (int y = 0, height = surface.getHeight(); y < height; ++y)
+		{
+			std::memcpy(data + y * rowBytes, surface.getData(cinder::ivec2{ 0, y }), rowBytes);
+		}
+	}
+
+	slot.pbo->unmap();
+
+	//returns immediately, the copy from the pixel buffer overlaps with the rendering
+	GLint oldUnpackAlignment;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldUnpackAlignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	slot.texture->update(slot.pbo, format, GL_UNSIGNED_BYTE);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, oldUnpackAlignment);
+
+	slot.fence = cinder::gl::Sync::create();
+
+	return slot.texture;
+}
+
+void TextureStreamer::reset()
+{
+	for (auto &slot : mSlots)
+	{
+		slot = Slot{};
+	}
+	mSize = cinder::ivec2{};
+}
+
+void TextureStreamer::allocate(const cinder::ivec2 &size, uint8_t pixelInc, bool alpha)
+{
+	mSize = size;
+	mPixelInc = pixelInc;
+
+	auto format = cinder::gl::Texture::Format{}.internalFormat(alpha ? GL_RGBA8 : GL_RGB8).loadTopDown();
+	GLsizeiptr bytes = static_cast<GLsizeiptr>(size.x) * size.y * pixelInc;
+
+	for (auto &slot : mSlots)
+	{
+		slot.texture = cinder::gl::Texture::create(size.x, size.y, format);
+		slot.texture->setTopDown(true);
+		slot.pbo = cinder::gl::Pbo::create(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+		slot.fence.reset();
+	}
+}
+
+}
\ No newline at end of file
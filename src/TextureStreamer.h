@@ -0,0 +1,65 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "cinder/Surface.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/gl/Pbo.h"
+#include "cinder/gl/Sync.h"
+
+#include <vector>
+
+namespace atarabi {
+
+/*
+* Uploads surfaces through a ring of preallocated textures and pixel buffers.
+*/
+class TextureStreamer {
+	struct Slot {
+		cinder::gl::TextureRef texture;
+		cinder::gl::PboRef pbo;
+		cinder::gl::SyncRef fence;
+	};
+
+public:
+	static const int DEFAULT_RING_SIZE = 3;
+
+	TextureStreamer(int ringSize = DEFAULT_RING_SIZE);
+
+	//! Uploads the surface to the next texture of the ring and returns it(must be called on the GL thread).
+	cinder::gl::TextureRef update(const cinder::Surface &surface);
+	//! Releases the textures and pixel buffers.
+	void reset();
+
+private:
+	void allocate(const cinder::ivec2 &size, uint8_t pixelInc, bool alpha);
+
+	std::vector<Slot> mSlots;
+	std::size_t mCurrent = 0;
+	cinder::ivec2 mSize;
+	uint8_t mPixelInc = 0;
+};
+
+}
\ No newline at end of file
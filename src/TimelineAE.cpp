@@ -0,0 +1,189 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+#include "TimelineAE.h"
+
+#include <algorithm>
+
+namespace atarabi {
+
+namespace {
+
+bool isRunningAt(cinder::TimelineItemRef &item, float time)
+{
+	return item->getLoop() || item->getPingPong() || item->isInfinite() || item->getEndTime() >= time;
+}
+
+} //anonymous namespace
+
+void TimelineAE::clear()
+{
+	Timeline::clear();
+	mOrder.clear();
+	mActive.clear();
+	mNext = 0;
+	mIndexValid = false;
+}
+
+void TimelineAE::evaluate(float time, bool removeCompleted)
+{
+	eraseMarked();
+	//the hidden adders invalidate the index, the count catches items added through a cinder::Timeline reference
+	if (!mIndexValid || mItems.size() != mIndexedCount)
+	{
+		rebuildIndex();
+	}
+
+	bool backward = time < mCurrentTime;
+	mCurrentTime = time;
+
+	std::size_t numRemoved = 0;
+	if (backward)
+	{
+		stepBackward(time);
+	}
+	else
+	{
+		numRemoved = stepForward(time, removeCompleted);
+	}
+
+	eraseMarked();
+	//items added by callbacks are indexed on the next step
+	if (mItems.size() + numRemoved == mIndexedCount)
+	{
+		mIndexedCount = mItems.size();
+	}
+	else
+	{
+		mIndexValid = false;
+	}
+}
+
+void TimelineAE::rebuildIndex()
+{
+	mOrder.clear();
+	mActive.clear();
+
+	for (auto &item : mItems)
+	{
+		if (!item.second->isMarkedForRemoval())
+		{
+			mOrder.push_back(item.second);
+		}
+	}
+	std::stable_sort(mOrder.begin(), mOrder.end(), [](const cinder::TimelineItemRef &lhs, const cinder::TimelineItemRef &rhs)
+	{
+		return lhs->getStartTime() < rhs->getStartTime();
+	});
+
+	mNext = 0;
+	while (mNext < mOrder.size() && mOrder[mNext]->getStartTime() <= mCurrentTime)
+	{
+		cinder::TimelineItemRef &item = mOrder[mNext++];
+		if (!item->isComplete())
+		{
+			mActive.push_back(item);
+		}
+	}
+
+	mIndexedCount = mItems.size();
+	mIndexValid = true;
+}
+
+std::size_t TimelineAE::stepForward(float time, bool removeCompleted)
+{
+	while (mNext < mOrder.size() && mOrder[mNext]->getStartTime() <= time)
+	{
+		cinder::TimelineItemRef &item = mOrder[mNext++];
+		if (!item->isMarkedForRemoval())
+		{
+			mActive.push_back(item);
+		}
+	}
+
+	//the list may grow while stepping, if an item's callback adds new ones
+	std::size_t numRemoved = 0;
+	std::size_t numKept = 0;
+	for (std::size_t i = 0, size = mActive.size(); i < size; ++i)
+	{
+		cinder::TimelineItemRef item = mActive[i];
+		if (item->isMarkedForRemoval())
+		{
+			continue;
+		}
+
+		item->stepTo(time, false);
+		if (item->isComplete())
+		{
+			if (removeCompleted && item->getAutoRemove())
+			{
+				item->markForRemoval();
+				++numRemoved;
+			}
+			continue;
+		}
+		mActive[numKept++] = item;
+	}
+	mActive.resize(numKept);
+
+	return numRemoved;
+}
+
+void TimelineAE::stepBackward(float time)
+{
+	//rewind the items which start after time, they are started again once time passes their start
+	std::size_t first = std::upper_bound(mOrder.begin(), mOrder.begin() + mNext, time, [](float t, const cinder::TimelineItemRef &item)
+	{
+		return t < item->getStartTime();
+	}) - mOrder.begin();
+
+	for (std::size_t i = first; i < mNext; ++i)
+	{
+		cinder::TimelineItemRef &item = mOrder[i];
+		if (!item->isMarkedForRemoval())
+		{
+			item->stepTo(time, true);
+		}
+	}
+	mNext = first;
+
+	//the items which completed before time already hold their final values
+	mActive.clear();
+	for (std::size_t i = 0; i < first; ++i)
+	{
+		cinder::TimelineItemRef &item = mOrder[i];
+		if (item->isMarkedForRemoval() || !isRunningAt(item, time))
+		{
+			continue;
+		}
+
+		item->stepTo(time, true);
+		if (!item->isComplete())
+		{
+			mActive.push_back(item);
+		}
+	}
+}
+
+} //namespace atarabi
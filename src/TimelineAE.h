@@ -0,0 +1,96 @@
+/*
+*	The MIT License (MIT)
+*
+*	Copyright (c) 2016 Kareobana
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in
+*	all copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*	THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "cinder/Timeline.h"
+
+#include <vector>
+#include <memory>
+#include <utility>
+
+namespace atarabi {
+
+class TimelineAE;
+typedef std::shared_ptr<TimelineAE> TimelineAERef;
+
+/*
+* A Timeline for offline rendering. Its items are indexed by start time, so that stepping only touches the items which are running.
+*/
+class TimelineAE : public cinder::Timeline {
+public:
+	static TimelineAERef create() { return TimelineAERef(new TimelineAE()); }
+
+	//! Steps forward by timestep.
+	void step(float timestep) { stepTo(mCurrentTime + timestep); }
+	//! Steps to absoluteTime. Only the items which have started and not yet completed are updated, and completed items are removed if their autoRemove is set.
+	void stepTo(float absoluteTime) { evaluate(absoluteTime, true); }
+	//! Evaluates every item at time, jumping straight there from the current time in either direction. Completed items are kept, so that the timeline can be evaluated at any time again.
+	void evaluateAt(float time) { evaluate(time, false); }
+
+	//! Removes all items.
+	void clear();
+	//! Rebuilds the index on the next step, call this after changing the start time of an item which has already been stepped.
+	void invalidateIndex() { mIndexValid = false; }
+
+	//! The functions which add or replace items hide cinder::Timeline's, so that the index is rebuilt on the next step.
+	//! Items added through a cinder::Timeline reference are only noticed when the number of items changes, call invalidateIndex() after re-applying tweens that way.
+	template<typename... Args>
+	auto apply(Args&&... args) -> decltype(std::declval<cinder::Timeline&>().apply(std::forward<Args>(args)...)) { mIndexValid = false; return Timeline::apply(std::forward<Args>(args)...); }
+	template<typename... Args>
+	auto applyPtr(Args&&... args) -> decltype(std::declval<cinder::Timeline&>().applyPtr(std::forward<Args>(args)...)) { mIndexValid = false; return Timeline::applyPtr(std::forward<Args>(args)...); }
+	template<typename... Args>
+	auto appendTo(Args&&... args) -> decltype(std::declval<cinder::Timeline&>().appendTo(std::forward<Args>(args)...)) { mIndexValid = false; return Timeline::appendTo(std::forward<Args>(args)...); }
+	template<typename... Args>
+	auto appendToPtr(Args&&... args) -> decltype(std::declval<cinder::Timeline&>().appendToPtr(std::forward<Args>(args)...)) { mIndexValid = false; return Timeline::appendToPtr(std::forward<Args>(args)...); }
+	template<typename... Args>
+	auto add(Args&&... args) -> decltype(std::declval<cinder::Timeline&>().add(std::forward<Args>(args)...)) { mIndexValid = false; return Timeline::add(std::forward<Args>(args)...); }
+	template<typename... Args>
+	auto insert(Args&&... args) -> decltype(std::declval<cinder::Timeline&>().insert(std::forward<Args>(args)...)) { mIndexValid = false; return Timeline::insert(std::forward<Args>(args)...); }
+	template<typename... Args>
+	auto remove(Args&&... args) -> decltype(std::declval<cinder::Timeline&>().remove(std::forward<Args>(args)...)) { mIndexValid = false; return Timeline::remove(std::forward<Args>(args)...); }
+	template<typename... Args>
+	auto removeTarget(Args&&... args) -> decltype(std::declval<cinder::Timeline&>().removeTarget(std::forward<Args>(args)...)) { mIndexValid = false; return Timeline::removeTarget(std::forward<Args>(args)...); }
+
+protected:
+	TimelineAE() {}
+
+private:
+	void evaluate(float time, bool removeCompleted);
+	void rebuildIndex();
+	std::size_t stepForward(float time, bool removeCompleted);
+	void stepBackward(float time);
+
+	//! all items sorted by start time
+	std::vector<cinder::TimelineItemRef> mOrder;
+	//! the first item in mOrder which has not started yet
+	std::size_t mNext = 0;
+	//! the items which have started and not yet completed
+	std::vector<cinder::TimelineItemRef> mActive;
+	std::size_t mIndexedCount = 0;
+	bool mIndexValid = false;
+};
+
+} //namespace atarabi
@@ -30,7 +30,8 @@ void _TBOX_PREFIX_App::updateAE()
 
 void _TBOX_PREFIX_App::drawAE()
 {
-	gl::clear(ColorA{ getParameter("Color") });
+	Color color = getParameter("Color");
+	gl::clear(color);
 }
 
 CINDER_APP(_TBOX_PREFIX_App, RendererGl(RendererGl::Options().msaa(16)), [](App::Settings* settings)